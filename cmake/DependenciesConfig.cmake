@@ -98,6 +98,12 @@ macro(configure_highfive)
   find_package(HighFive REQUIRED)
 endmacro(configure_highfive)
 
+macro(configure_threads)
+  message ("Dependency check for threads...")
+  set(THREADS_PREFER_PTHREAD_FLAG ON)
+  find_package(Threads REQUIRED)
+endmacro(configure_threads)
+
 macro(configure_boost)
   message ("Dependency check for boost...")
   if(${ENABLE_BOOST})
@@ -34,11 +34,16 @@ static const std::string SAVE_FREQ_TAG = "save_freq";
 static const std::string SAVE_PRED_TAG = "save_pred";
 static const std::string SAVE_MODEL_TAG = "save_model";
 static const std::string CHECKPOINT_FREQ_TAG = "checkpoint_freq";
+static const std::string SAVE_CHUNK_ROWS_TAG = "save_chunk_rows";
+static const std::string SAVE_DEFLATE_TAG = "save_deflate";
+static const std::string SAVE_SAMPLE_BITS_TAG = "save_sample_bits";
 static const std::string VERBOSE_TAG = "verbose";
 static const std::string BURNING_TAG = "burnin";
 static const std::string NSAMPLES_TAG = "nsamples";
 static const std::string NUM_LATENT_TAG = "num_latent";
 static const std::string NUM_THREADS_TAG = "num_threads";
+static const std::string PIPELINED_EVAL_TAG = "pipelined_eval";
+static const std::string EVAL_THREADS_TAG = "eval_threads";
 static const std::string RANDOM_SEED_SET_TAG = "random_seed_set";
 static const std::string RANDOM_SEED_TAG = "random_seed";
 static const std::string INIT_MODEL_TAG = "init_model";
@@ -133,12 +138,17 @@ int Config::BURNIN_DEFAULT_VALUE = 200;
 int Config::NSAMPLES_DEFAULT_VALUE = 800;
 int Config::NUM_LATENT_DEFAULT_VALUE = 32;
 int Config::NUM_THREADS_DEFAULT_VALUE = 0; // as many as you want
+bool Config::PIPELINED_EVAL_DEFAULT_VALUE = false;
+int Config::EVAL_THREADS_DEFAULT_VALUE = 1;
 ModelInitTypes Config::INIT_MODEL_DEFAULT_VALUE = ModelInitTypes::zero;
 std::string Config::SAVE_NAME_DEFAULT_VALUE = std::string();
 int Config::SAVE_FREQ_DEFAULT_VALUE = 0;
 bool Config::SAVE_PRED_DEFAULT_VALUE = true;
 bool Config::SAVE_MODEL_DEFAULT_VALUE = true;
 int Config::CHECKPOINT_FREQ_DEFAULT_VALUE = 0;
+int Config::SAVE_CHUNK_ROWS_DEFAULT_VALUE = 0;
+int Config::SAVE_DEFLATE_DEFAULT_VALUE = 0;
+int Config::SAVE_SAMPLE_BITS_DEFAULT_VALUE = 0;
 int Config::VERBOSE_DEFAULT_VALUE = 0;
 const std::string Config::STATUS_DEFAULT_VALUE = "";
 bool Config::ENABLE_BETA_PRECISION_SAMPLING_DEFAULT_VALUE = true;
@@ -156,6 +166,9 @@ Config::Config()
    m_save_pred = Config::SAVE_PRED_DEFAULT_VALUE;
    m_save_model = Config::SAVE_MODEL_DEFAULT_VALUE;
    m_checkpoint_freq = Config::CHECKPOINT_FREQ_DEFAULT_VALUE;
+   m_save_chunk_rows = Config::SAVE_CHUNK_ROWS_DEFAULT_VALUE;
+   m_save_deflate = Config::SAVE_DEFLATE_DEFAULT_VALUE;
+   m_save_sample_bits = Config::SAVE_SAMPLE_BITS_DEFAULT_VALUE;
 
    m_random_seed_set = false;
    m_random_seed = Config::RANDOM_SEED_DEFAULT_VALUE;
@@ -165,6 +178,8 @@ Config::Config()
    m_nsamples = Config::NSAMPLES_DEFAULT_VALUE;
    m_num_latent = Config::NUM_LATENT_DEFAULT_VALUE;
    m_num_threads = Config::NUM_THREADS_DEFAULT_VALUE;
+   m_pipelined_eval = Config::PIPELINED_EVAL_DEFAULT_VALUE;
+   m_eval_threads = Config::EVAL_THREADS_DEFAULT_VALUE;
 
    m_threshold = Config::THRESHOLD_DEFAULT_VALUE;
    m_classify = false;
@@ -298,6 +313,9 @@ bool Config::validate() const
          case PriorTypes::macau:
          case PriorTypes::macauone:
             THROWERROR_ASSERT_MSG(hasSideInfo(i), priorTypeToString(pt) + " prior in dimension " + std::to_string(i) + " needs side info");
+            // dense and binary side info have no float variant
+            THROWERROR_ASSERT_MSG(!getSideInfoConfig(i).getMixedPrecision() || !(getSideInfoConfig(i).isDense() || getSideInfoConfig(i).isBinary()),
+                                  "mixed_precision in dimension " + std::to_string(i) + " needs sparse, non-binary side info");
             break;
          default:
             THROWERROR("Unknown prior");
@@ -307,6 +325,12 @@ bool Config::validate() const
 
    getTrain().getNoiseConfig().validate();
 
+   THROWERROR_ASSERT_MSG(m_save_chunk_rows >= 0, "save_chunk_rows should be >= 0");
+   THROWERROR_ASSERT_MSG(m_save_deflate >= 0 && m_save_deflate <= 9, "save_deflate should be between 0 and 9");
+   THROWERROR_ASSERT_MSG(m_save_sample_bits == 0 || m_save_sample_bits == 32 || m_save_sample_bits == 16,
+                         "save_sample_bits should be 0 (full precision), 32 or 16");
+   THROWERROR_ASSERT_MSG(m_eval_threads >= 1, "eval_threads should be >= 1");
+
    // validate propagated posterior
    for(uint64_t i=0; i<getTrain().getNModes(); ++i)
    {
@@ -356,6 +380,9 @@ HDF5Group &Config::save(HDF5Group &cfg_file) const
    cfg_file.put(OPTIONS_SECTION_TAG, SAVE_PRED_TAG, m_save_pred);
    cfg_file.put(OPTIONS_SECTION_TAG, SAVE_MODEL_TAG, m_save_model);
    cfg_file.put(OPTIONS_SECTION_TAG, CHECKPOINT_FREQ_TAG, m_checkpoint_freq);
+   cfg_file.put(OPTIONS_SECTION_TAG, SAVE_CHUNK_ROWS_TAG, m_save_chunk_rows);
+   cfg_file.put(OPTIONS_SECTION_TAG, SAVE_DEFLATE_TAG, m_save_deflate);
+   cfg_file.put(OPTIONS_SECTION_TAG, SAVE_SAMPLE_BITS_TAG, m_save_sample_bits);
 
    //general data
    cfg_file.put(OPTIONS_SECTION_TAG, VERBOSE_TAG, m_verbose);
@@ -363,6 +390,8 @@ HDF5Group &Config::save(HDF5Group &cfg_file) const
    cfg_file.put(OPTIONS_SECTION_TAG, NSAMPLES_TAG, m_nsamples);
    cfg_file.put(OPTIONS_SECTION_TAG, NUM_LATENT_TAG, m_num_latent);
    cfg_file.put(OPTIONS_SECTION_TAG, NUM_THREADS_TAG, m_num_threads);
+   cfg_file.put(OPTIONS_SECTION_TAG, PIPELINED_EVAL_TAG, m_pipelined_eval);
+   cfg_file.put(OPTIONS_SECTION_TAG, EVAL_THREADS_TAG, m_eval_threads);
    cfg_file.put(OPTIONS_SECTION_TAG, RANDOM_SEED_SET_TAG, m_random_seed_set);
    cfg_file.put(OPTIONS_SECTION_TAG, RANDOM_SEED_TAG, m_random_seed);
    cfg_file.put(OPTIONS_SECTION_TAG, INIT_MODEL_TAG, modelInitTypeToString(m_model_init_type));
@@ -450,6 +479,9 @@ bool Config::restore(const HDF5Group &cfg_file)
    m_save_pred  = cfg_file.get(OPTIONS_SECTION_TAG, SAVE_PRED_TAG, Config::SAVE_PRED_DEFAULT_VALUE);
    m_save_model = cfg_file.get(OPTIONS_SECTION_TAG, SAVE_MODEL_TAG, Config::SAVE_MODEL_DEFAULT_VALUE);
    m_checkpoint_freq = cfg_file.get(OPTIONS_SECTION_TAG, CHECKPOINT_FREQ_TAG, Config::CHECKPOINT_FREQ_DEFAULT_VALUE);
+   m_save_chunk_rows = cfg_file.get(OPTIONS_SECTION_TAG, SAVE_CHUNK_ROWS_TAG, Config::SAVE_CHUNK_ROWS_DEFAULT_VALUE);
+   m_save_deflate = cfg_file.get(OPTIONS_SECTION_TAG, SAVE_DEFLATE_TAG, Config::SAVE_DEFLATE_DEFAULT_VALUE);
+   m_save_sample_bits = cfg_file.get(OPTIONS_SECTION_TAG, SAVE_SAMPLE_BITS_TAG, Config::SAVE_SAMPLE_BITS_DEFAULT_VALUE);
 
    //restore general data
    m_verbose = cfg_file.get(OPTIONS_SECTION_TAG, VERBOSE_TAG, Config::VERBOSE_DEFAULT_VALUE);
@@ -457,6 +489,8 @@ bool Config::restore(const HDF5Group &cfg_file)
    m_nsamples = cfg_file.get(OPTIONS_SECTION_TAG, NSAMPLES_TAG, Config::NSAMPLES_DEFAULT_VALUE);
    m_num_latent = cfg_file.get(OPTIONS_SECTION_TAG, NUM_LATENT_TAG, Config::NUM_LATENT_DEFAULT_VALUE);
    m_num_threads = cfg_file.get(OPTIONS_SECTION_TAG, NUM_THREADS_TAG, Config::NUM_THREADS_DEFAULT_VALUE);
+   m_pipelined_eval = cfg_file.get(OPTIONS_SECTION_TAG, PIPELINED_EVAL_TAG, Config::PIPELINED_EVAL_DEFAULT_VALUE);
+   m_eval_threads = cfg_file.get(OPTIONS_SECTION_TAG, EVAL_THREADS_TAG, Config::EVAL_THREADS_DEFAULT_VALUE);
    m_random_seed_set = cfg_file.get(OPTIONS_SECTION_TAG, RANDOM_SEED_SET_TAG,  false);
    m_random_seed = cfg_file.get(OPTIONS_SECTION_TAG, RANDOM_SEED_TAG, Config::RANDOM_SEED_DEFAULT_VALUE);
    m_model_init_type = stringToModelInitType(cfg_file.get(OPTIONS_SECTION_TAG, INIT_MODEL_TAG, modelInitTypeToString(Config::INIT_MODEL_DEFAULT_VALUE)));
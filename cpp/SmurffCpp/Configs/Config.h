@@ -49,6 +49,8 @@ public:
    static int NSAMPLES_DEFAULT_VALUE;
    static int NUM_LATENT_DEFAULT_VALUE;
    static int NUM_THREADS_DEFAULT_VALUE;
+   static bool PIPELINED_EVAL_DEFAULT_VALUE;
+   static int EVAL_THREADS_DEFAULT_VALUE;
    static bool POSTPROP_DEFAULT_VALUE;
    static ModelInitTypes INIT_MODEL_DEFAULT_VALUE;
    static std::string SAVE_NAME_DEFAULT_VALUE;
@@ -56,6 +58,9 @@ public:
    static bool SAVE_PRED_DEFAULT_VALUE;
    static bool SAVE_MODEL_DEFAULT_VALUE;
    static int CHECKPOINT_FREQ_DEFAULT_VALUE;
+   static int SAVE_CHUNK_ROWS_DEFAULT_VALUE;
+   static int SAVE_DEFLATE_DEFAULT_VALUE;
+   static int SAVE_SAMPLE_BITS_DEFAULT_VALUE;
    static int VERBOSE_DEFAULT_VALUE;
    static const std::string STATUS_DEFAULT_VALUE;
    static bool ENABLE_BETA_PRECISION_SAMPLING_DEFAULT_VALUE;
@@ -89,6 +94,9 @@ private:
    bool m_save_pred;
    bool m_save_model;
    int m_checkpoint_freq;
+   int m_save_chunk_rows;
+   int m_save_deflate;
+   int m_save_sample_bits;
 
    //-- general
    bool m_random_seed_set;
@@ -98,6 +106,8 @@ private:
    int m_nsamples;
    int m_num_latent;
    int m_num_threads; 
+   bool m_pipelined_eval;
+   int m_eval_threads;
 
    //-- binary classification
    bool m_classify;
@@ -329,6 +339,39 @@ public:
       m_save_pred = value;
    }
 
+   int getSaveChunkRows() const
+   {
+      return m_save_chunk_rows;
+   }
+
+   // rows per HDF5 chunk, 0 = about 1MB per chunk
+   void setSaveChunkRows(int value)
+   {
+      m_save_chunk_rows = value;
+   }
+
+   int getSaveDeflate() const
+   {
+      return m_save_deflate;
+   }
+
+   // gzip level of saved datasets, 0 = uncompressed
+   void setSaveDeflate(int value)
+   {
+      m_save_deflate = value;
+   }
+
+   int getSaveSampleBits() const
+   {
+      return m_save_sample_bits;
+   }
+
+   // store latent samples as 32 or 16 bit floats, 0 = full precision
+   void setSaveSampleBits(int value)
+   {
+      m_save_sample_bits = value;
+   }
+
    bool getSaveModel() const
    {
       return m_save_model;
@@ -433,6 +476,28 @@ public:
        m_num_threads = value;
    }
 
+   bool getPipelinedEval() const
+   {
+       return m_pipelined_eval;
+   }
+
+   // evaluate the test set of sample t while sample t+1 is drawn
+   void setPipelinedEval(bool value)
+   {
+       m_pipelined_eval = value;
+   }
+
+   int getEvalThreads() const
+   {
+       return m_eval_threads;
+   }
+
+   // threads of the pipelined evaluation, on top of num_threads for the sampler
+   void setEvalThreads(int value)
+   {
+       m_eval_threads = value;
+   }
+
    std::string getIniName() const
    {
        return m_ini_name;
@@ -1,6 +1,7 @@
 #include "DataConfig.h"
 
 #include <numeric>
+#include <algorithm>
 
 #include <SmurffCpp/Utils/PVec.hpp>
 #include <SmurffCpp/Utils/HDF5Group.h>
@@ -196,6 +197,17 @@ bool DataConfig::isMatrix() const
    return m_isMatrix;
 }
 
+//true for sparse matrices where all stored values are 1
+bool DataConfig::isBinary() const
+{
+   if (!hasData() || isDense() || !isMatrix())
+      return false;
+
+   const auto &m = getSparseMatrixData();
+   const auto *values = m.valuePtr();
+   return std::all_of(values, values + m.nonZeros(), [](float_type v) { return v == 1.0; });
+}
+
 std::uint64_t DataConfig::getNNZ() const
 {
    THROWERROR_ASSERT(hasData());
@@ -68,6 +68,7 @@ namespace smurff
       bool isMatrix() const;
       bool isDense() const;
       bool isScarce() const;
+      bool isBinary() const;
 
       std::uint64_t getNModes() const;
       std::uint64_t getNNZ() const;
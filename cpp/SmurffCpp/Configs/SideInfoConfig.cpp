@@ -13,11 +13,13 @@ static const std::string SIDE_INFO_PREFIX = "side_info";
 static const std::string TOL_TAG = "tol";
 static const std::string DIRECT_TAG = "direct";
 static const std::string THROW_ON_CHOLESKY_ERROR_TAG = "throw_on_cholesky_error";
+static const std::string MIXED_PRECISION_TAG = "mixed_precision";
 static const std::string NUMBER_TAG = "nr";
 
 const bool   SideInfoConfig::DIRECT_DEFAULT_VALUE = true;
 const double SideInfoConfig::BETA_PRECISION_DEFAULT_VALUE = 10.0;
 const double SideInfoConfig::TOL_DEFAULT_VALUE = 1e-6;
+const bool   SideInfoConfig::MIXED_PRECISION_DEFAULT_VALUE = false;
 
 SideInfoConfig::SideInfoConfig(const Matrix &data, const NoiseConfig &ncfg)
    : DataConfig(data, ncfg)
@@ -25,6 +27,7 @@ SideInfoConfig::SideInfoConfig(const Matrix &data, const NoiseConfig &ncfg)
    m_tol = SideInfoConfig::TOL_DEFAULT_VALUE;
    m_direct = SideInfoConfig::DIRECT_DEFAULT_VALUE;
    m_throw_on_cholesky_error = false;
+   m_mixed_precision = SideInfoConfig::MIXED_PRECISION_DEFAULT_VALUE;
 }
 
 SideInfoConfig::SideInfoConfig(const SparseMatrix &data, const NoiseConfig &ncfg)
@@ -33,6 +36,7 @@ SideInfoConfig::SideInfoConfig(const SparseMatrix &data, const NoiseConfig &ncfg
    m_tol = SideInfoConfig::TOL_DEFAULT_VALUE;
    m_direct = SideInfoConfig::DIRECT_DEFAULT_VALUE;
    m_throw_on_cholesky_error = false;
+   m_mixed_precision = SideInfoConfig::MIXED_PRECISION_DEFAULT_VALUE;
 }
 
 void SideInfoConfig::save(HDF5Group& cfg_file, std::size_t prior_index) const
@@ -43,6 +47,7 @@ void SideInfoConfig::save(HDF5Group& cfg_file, std::size_t prior_index) const
    cfg_file.put(sectionName, TOL_TAG, m_tol);
    cfg_file.put(sectionName, DIRECT_TAG, m_direct);
    cfg_file.put(sectionName, THROW_ON_CHOLESKY_ERROR_TAG, m_throw_on_cholesky_error);
+   cfg_file.put(sectionName, MIXED_PRECISION_TAG, m_mixed_precision);
 
    //data
    DataConfig::save(cfg_file, sectionName);
@@ -61,6 +66,7 @@ bool SideInfoConfig::restore(const HDF5Group& cfg_file, std::size_t prior_index)
    m_tol = cfg_file.get(sectionName, TOL_TAG, SideInfoConfig::TOL_DEFAULT_VALUE);
    m_direct = cfg_file.get(sectionName, DIRECT_TAG, false);
    m_throw_on_cholesky_error = cfg_file.get(sectionName, THROW_ON_CHOLESKY_ERROR_TAG, false);
+   m_mixed_precision = cfg_file.get(sectionName, MIXED_PRECISION_TAG, SideInfoConfig::MIXED_PRECISION_DEFAULT_VALUE);
 
    DataConfig::restore(cfg_file, sectionName);
 
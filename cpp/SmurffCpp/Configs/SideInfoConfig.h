@@ -16,11 +16,13 @@ namespace smurff
       static const bool DIRECT_DEFAULT_VALUE;
       static const double BETA_PRECISION_DEFAULT_VALUE;
       static const double TOL_DEFAULT_VALUE;
+      static const bool MIXED_PRECISION_DEFAULT_VALUE;
 
    private:
       double m_tol = TOL_DEFAULT_VALUE;
       bool m_direct = DIRECT_DEFAULT_VALUE;
       bool m_throw_on_cholesky_error = false;
+      bool m_mixed_precision = MIXED_PRECISION_DEFAULT_VALUE;
 
    public:
       SideInfoConfig() {}; //empty
@@ -58,6 +60,18 @@ namespace smurff
          m_throw_on_cholesky_error = value;
       }
 
+      // store sparse side info in float, solve with float CG + refinement;
+      // only for sparse, non-binary side info (see Config::validate); the CG only runs with direct = false
+      bool getMixedPrecision() const
+      {
+         return m_mixed_precision;
+      }
+
+      void setMixedPrecision(bool value)
+      {
+         m_mixed_precision = value;
+      }
+
    public:
       void save(HDF5Group& writer, std::size_t prior_index) const;
       bool restore(const HDF5Group& reader, std::size_t prior_index);
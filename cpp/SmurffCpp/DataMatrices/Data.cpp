@@ -84,6 +84,28 @@ void Data::setNoiseModel(std::unique_ptr<INoiseModel> &&nm)
    noise_ptr = std::move(nm);
 }
 
+int Data::row_nnz(uint32_t, int) const
+{
+   return -1;
+}
+
+void Data::getMuRows(const SubModel&, uint32_t, int, Eigen::Ref<Vector>, Eigen::Ref<Matrix>) const
+{
+   THROWERROR_NOTIMPL();
+}
+
+void Data::setSplitNNZ(uint32_t mode, int nnz)
+{
+   if (m_split_nnz.size() <= mode)
+      m_split_nnz.resize(mode + 1, -1);
+   m_split_nnz[mode] = nnz;
+}
+
+int Data::splitNNZ(uint32_t mode) const
+{
+   return mode < m_split_nnz.size() ? m_split_nnz[mode] : -1;
+}
+
 //#### info functions ####
 
 std::ostream& Data::info(std::ostream& os, std::string indent)
@@ -67,7 +67,21 @@ namespace smurff
    public:
       virtual double train_rmse(const SubModel& model) const = 0;
       virtual void update_pnm(const SubModel& model, uint32_t mode) = 0;
-      virtual void getMuLambda(const SubModel& model, uint32_t mode, int d, Vector& rr, Matrix& MM) const = 0;
+      virtual void getMuLambda(const SubModel& model, uint32_t mode, int d, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> MM) const = 0;
+
+      // number of observed values in row d of mode, -1 if not known
+      virtual int row_nnz(uint32_t mode, int d) const;
+      // like getMuLambda, but returns the observed rows of V scaled with sqrt(alpha)
+      // in the first row_nnz(mode, d) rows of VV, instead of summing their products in MM
+      virtual void getMuRows(const SubModel& model, uint32_t mode, int d, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> VV) const;
+
+      // rows of mode with at least nnz observations are split into tasks by getMuLambda,
+      // -1 (default) lets the data decide
+      void setSplitNNZ(uint32_t mode, int nnz);
+      int splitNNZ(uint32_t mode) const;
+
+   private:
+      std::vector<int> m_split_nnz;
 
    public:
       virtual double sumsq(const SubModel& model) const = 0;
@@ -9,7 +9,7 @@ DenseMatrixData::DenseMatrixData(Matrix Y)
 }
 
 //d is an index of column in U matrix
-void DenseMatrixData::getMuLambda(const SubModel& model, uint32_t mode, int d, Vector& rr, Matrix& MM) const
+void DenseMatrixData::getMuLambda(const SubModel& model, uint32_t mode, int d, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> MM) const
 {
     auto &Y = this->Y(mode).row(d);
     auto Vf = *model.CVbegin(mode);
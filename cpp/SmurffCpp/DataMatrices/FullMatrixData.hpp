@@ -14,6 +14,7 @@ namespace smurff
    {
    protected:
       Matrix VV[2]; // sum of v * vT, where v is column of V
+      thread_vector<Matrix> VVs; // per-thread partial sums of VV
 
    public:
       FullMatrixData(YType Y) 
@@ -28,17 +29,18 @@ namespace smurff
       {
          auto Vf = *model.CVbegin(mode);
          const int nl = model.nlatent();
-         thread_vector<Matrix> VVs(Matrix::Zero(nl, nl));
+         if (VVs.size() != threads::get_max_threads() || VVs.begin()->rows() != nl)
+            VVs.init(Matrix::Zero(nl, nl));
 
          //for each column v of Vf - calculate v * vT and add to VVs
-         #pragma omp parallel for schedule(guided) shared(VVs)
+         #pragma omp parallel for schedule(guided)
          for(int n = 0; n < Vf.rows(); n++) 
          {
             auto v = Vf.row(n);
-            VVs.local() += v.transpose() * v; // VVs = Vvs + vT * v
+            VVs.local().noalias() += v.transpose() * v; // VVs = Vvs + vT * v
          }
 
-         VV[mode] = VVs.combine(); //accumulate sum
+         VVs.combine_and_reset(VV[mode]); //accumulate sum
       }
 
       std::uint64_t nna() const override
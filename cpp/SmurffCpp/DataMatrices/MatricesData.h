@@ -24,7 +24,7 @@ namespace smurff
 
       // update noise and precision/mean
       void update(const SubModel& model) override;
-      void getMuLambda(const SubModel& model, uint32_t mode, int d, Vector& rr, Matrix& MM) const override;
+      void getMuLambda(const SubModel& model, uint32_t mode, int d, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> MM) const override;
       void update_pnm(const SubModel& model, uint32_t mode) override;
 
       //-- print info
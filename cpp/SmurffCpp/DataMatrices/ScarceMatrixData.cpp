@@ -43,7 +43,7 @@ std::ostream& ScarceMatrixData::info(std::ostream& os, std::string indent)
     return os;
 }
 
-void ScarceMatrixData::getMuLambda(const SubModel& model, std::uint32_t mode, int n, Vector& rr, Matrix& MM) const
+void ScarceMatrixData::getMuLambda(const SubModel& model, std::uint32_t mode, int n, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> MM) const
 {
    auto &Y = this->Y(mode);
    const int num_latent = model.nlatent();
@@ -52,21 +52,53 @@ void ScarceMatrixData::getMuLambda(const SubModel& model, std::uint32_t mode, in
    auto from = Y.outerIndexPtr()[n];
    auto to = Y.outerIndexPtr()[n+1];
 
-   auto getMuLambdaBasic = [&model, this, mode, n](int from, int to, Vector& rr, Matrix& MM) -> void
+   auto getMuLambdaBasic = [&model, this, mode, n](int from, int to, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> MM) -> void
    {
        auto &Y = this->Y(mode);
        auto Vf = *model.CVbegin(mode);
        auto &ns = noise();
 
-       for(int i = from; i < to; ++i)
+       // latent dimensions that are zero in V do not contribute
+       const auto &active = model.active(mode);
+       const int nactive = active.size();
+
+       if (nactive == model.nlatent())
+       {
+          for(int i = from; i < to; ++i)
+          {
+              auto val = Y.valuePtr()[i];
+              auto idx = Y.innerIndexPtr()[i];
+              const auto &row = Vf.row(idx);
+              auto pos = this->pos(mode, n, idx);
+              double noisy_val = ns.sample(model, pos, val);
+              rr.noalias() += row * noisy_val;
+              MM.triangularView<Eigen::Lower>() +=  ns.getAlpha() * row.transpose() * row;
+          }
+       }
+       else
        {
-           auto val = Y.valuePtr()[i];
-           auto idx = Y.innerIndexPtr()[i];
-           const auto &row = Vf.row(idx);
-           auto pos = this->pos(mode, n, idx);
-           double noisy_val = ns.sample(model, pos, val);
-           rr.noalias() += row * noisy_val;
-           MM.triangularView<Eigen::Lower>() +=  ns.getAlpha() * row.transpose() * row;
+          // accumulate on the compacted active columns, then scatter
+          Vector row(nactive);
+          Vector rr_active = Vector::Zero(nactive);
+          Matrix MM_active = Matrix::Zero(nactive, nactive);
+
+          for(int i = from; i < to; ++i)
+          {
+              auto val = Y.valuePtr()[i];
+              auto idx = Y.innerIndexPtr()[i];
+              for (int a = 0; a < nactive; ++a) row(a) = Vf(idx, active[a]);
+              auto pos = this->pos(mode, n, idx);
+              double noisy_val = ns.sample(model, pos, val);
+              rr_active.noalias() += row * noisy_val;
+              MM_active.triangularView<Eigen::Lower>() +=  ns.getAlpha() * row.transpose() * row;
+          }
+
+          for (int a = 0; a < nactive; ++a)
+          {
+              rr(active[a]) += rr_active(a);
+              for (int b = 0; b <= a; ++b)
+                  MM(active[a], active[b]) += MM_active(a, b);
+          }
        }
 
        // make MM complete
@@ -75,7 +107,12 @@ void ScarceMatrixData::getMuLambda(const SubModel& model, std::uint32_t mode, in
 
    
 
-   bool in_parallel = (local_nnz >10000) || ((double)local_nnz > (double)total_nnz / 100.);
+   // the row scheduler of the prior knows which rows are heavy,
+   // otherwise split large rows
+   const int split_nnz = splitNNZ(mode);
+   bool in_parallel = (split_nnz >= 0)
+      ? (local_nnz >= split_nnz)
+      : (local_nnz >10000) || ((double)local_nnz > (double)total_nnz / 100.);
    if (in_parallel) 
    {
        const int task_size = ceil(local_nnz / 100.0);
@@ -106,6 +143,34 @@ void ScarceMatrixData::getMuLambda(const SubModel& model, std::uint32_t mode, in
    }
 }
 
+int ScarceMatrixData::row_nnz(std::uint32_t mode, int n) const
+{
+   auto &Y = this->Y(mode);
+   return Y.outerIndexPtr()[n+1] - Y.outerIndexPtr()[n];
+}
+
+void ScarceMatrixData::getMuRows(const SubModel& model, std::uint32_t mode, int n, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> VV) const
+{
+   auto &Y = this->Y(mode);
+   auto Vf = *model.CVbegin(mode);
+   auto &ns = noise();
+   const int from = Y.outerIndexPtr()[n];
+   const int to = Y.outerIndexPtr()[n+1];
+
+   THROWERROR_ASSERT(VV.rows() >= to - from);
+
+   for(int i = from; i < to; ++i)
+   {
+      auto val = Y.valuePtr()[i];
+      auto idx = Y.innerIndexPtr()[i];
+      const auto &row = Vf.row(idx);
+      auto pos = this->pos(mode, n, idx);
+      double noisy_val = ns.sample(model, pos, val);
+      rr.noalias() += row * noisy_val;
+      VV.row(i - from) = std::sqrt(ns.getAlpha()) * row;
+   }
+}
+
 void ScarceMatrixData::update_pnm(const SubModel &, std::uint32_t mode)
 {
    //can not cache VV because of scarceness
@@ -19,7 +19,9 @@ namespace smurff
 
       std::ostream& info(std::ostream& os, std::string indent) override;
 
-      void getMuLambda(const SubModel& model, std::uint32_t mode, int d, Vector& rr, Matrix& MM) const override;
+      void getMuLambda(const SubModel& model, std::uint32_t mode, int d, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> MM) const override;
+      int row_nnz(std::uint32_t mode, int d) const override;
+      void getMuRows(const SubModel& model, std::uint32_t mode, int d, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> VV) const override;
       void update_pnm(const SubModel& model, std::uint32_t mode) override;
 
       std::uint64_t nna() const override;
@@ -8,7 +8,7 @@ SparseMatrixData::SparseMatrixData(SparseMatrix Y)
    this->name = "SparseMatrixData [fully known]";
 }
 
-void SparseMatrixData::getMuLambda(const SubModel& model, uint32_t mode, int d, Vector& rr, Matrix& MM) const
+void SparseMatrixData::getMuLambda(const SubModel& model, uint32_t mode, int d, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> MM) const
 {
     const auto& Y = this->Y(mode);
     auto Vf = *model.CVbegin(mode);
@@ -9,7 +9,7 @@ namespace smurff
    public:
       SparseMatrixData(SparseMatrix Y);
 
-      void getMuLambda(const SubModel& model, std::uint32_t mode, int d, Vector& rr, Matrix& MM) const override;
+      void getMuLambda(const SubModel& model, std::uint32_t mode, int d, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> MM) const override;
 
    public:
       double train_rmse(const SubModel& model) const override;
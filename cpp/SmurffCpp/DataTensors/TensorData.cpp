@@ -134,7 +134,7 @@ double TensorData::train_rmse(const SubModel& model) const
 //this function selects d'th hyperplane from mode`th SparseMode
 //it does j multiplications
 //where each multiplication is a cwiseProduct of columns from each V matrix
-void TensorData::getMuLambda(const SubModel& model, uint32_t mode, int d, Vector& rr, Matrix& MM) const
+void TensorData::getMuLambda(const SubModel& model, uint32_t mode, int d, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> MM) const
 {
    std::shared_ptr<SparseMode> sview = Y(mode); //get tensor rotation for mode
    
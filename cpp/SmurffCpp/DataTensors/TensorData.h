@@ -41,7 +41,7 @@ public:
 
 public:
    double train_rmse(const SubModel& model) const override;
-   void getMuLambda(const SubModel& model, uint32_t mode, int d, Vector& rr, Matrix& MM) const override;
+   void getMuLambda(const SubModel& model, uint32_t mode, int d, Eigen::Ref<Vector> rr, Eigen::Ref<Matrix> MM) const override;
    void update_pnm(const SubModel& model, uint32_t mode) override;
 
 public:
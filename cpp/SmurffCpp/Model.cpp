@@ -21,6 +21,8 @@
 
 #include <SmurffCpp/Utils/Error.h>
 #include <SmurffCpp/Utils/SaveState.h>
+#include <SmurffCpp/Utils/MatrixUtils.h>
+#include <SmurffCpp/Utils/counters.h>
 
 namespace smurff {
 
@@ -68,11 +70,12 @@ void Model::init(int num_latent, const PVec<>& dims, ModelInitTypes model_init_t
       if (aggregate)
       {
          m_aggr_sum.push_back(Matrix::Zero(dims[i], m_num_latent));
-         m_aggr_dot.push_back(Matrix::Zero(dims[i], m_num_latent * m_num_latent));
+         m_aggr_dot.push_back(Matrix::Zero(dims[i], matrix_utils::packed_size(m_num_latent)));
       }
    }
 
    Pcache.init(Array1D::Ones(m_num_latent));
+   resetActive();
 }
 
 Matrix &Model::getLinkMatrix(int mode)
@@ -97,6 +100,20 @@ const Vector &Model::getMu(int mode) const
 
 double Model::predict(const PVec<> &pos) const
 {
+   // only loop over the active latent dimensions
+   if ((int)m_active.size() < nlatent())
+   {
+      double ret = 0.0;
+      for (int k : m_active)
+      {
+         double p = 1.0;
+         for(uint32_t d = 0; d < nmodes(); ++d)
+            p *= U(d)(pos.at(d), k);
+         ret += p;
+      }
+      return ret;
+   }
+
    if (nmodes() == 2)
    {
       return row(0, pos[0]).dot(row(1, pos[1]));
@@ -170,19 +187,113 @@ SubModel Model::full()
    return SubModel(*this);
 }
 
+void Model::updateActive(int m)
+{
+   const Matrix &u = U(m);
+   auto &nonzero = m_nonzero_cols.at(m);
+
+   // skipped modes (see restore) have no rows and are considered active
+   if (u.rows() == 0)
+      nonzero.assign(nlatent(), true);
+   else
+   {
+      auto any = (u.array() != 0).colwise().any();
+      for (int k = 0; k < nlatent(); ++k)
+         nonzero[k] = any(k);
+   }
+
+   rebuildActive();
+}
+
+void Model::resetActive()
+{
+   m_nonzero_cols.assign(nmodes(), std::vector<bool>(nlatent(), true));
+   rebuildActive();
+}
+
+void Model::rebuildActive()
+{
+   m_active.clear();
+   m_active_except.assign(nmodes(), std::vector<int>());
+
+   for (int k = 0; k < nlatent(); ++k)
+   {
+      int nzero = 0, zero_mode = -1;
+      for (std::uint64_t d = 0; d < nmodes(); ++d)
+         if (!m_nonzero_cols.at(d).at(k)) { nzero++; zero_mode = d; }
+
+      if (nzero == 0) m_active.push_back(k);
+      for (std::uint64_t d = 0; d < nmodes(); ++d)
+         if (nzero == 0 || (nzero == 1 && zero_mode == (int)d))
+            m_active_except.at(d).push_back(k);
+   }
+}
+
+const std::vector<int> &Model::active(int except_mode) const
+{
+   if (except_mode < 0)
+      return m_active;
+
+   return m_active_except.at(except_mode);
+}
+
 void Model::updateAggr(int m, int i)
 {
    if (!m_collect_aggr) return;
 
    const auto &r = row(m, i);
-   Matrix cov = (r.transpose() * r);
    m_aggr_sum.at(m).row(i) += r;
-   m_aggr_dot.at(m).row(i) += Eigen::Map<Vector>(cov.data(), nlatent() * nlatent());
+
+   // packed lower triangle of r' * r
+   float_type *dot = m_aggr_dot.at(m).row(i).data();
+   for (int a = 0; a < nlatent(); ++a)
+   {
+      Eigen::Map<Vector>(dot, a + 1) += r(a) * r.head(a + 1);
+      dot += a + 1;
+   }
 }
 
+// rows per block in the aggregation pass
+static const int AGGR_BLOCK = 256;
+
 void Model::updateAggr(int m)
 {
    m_num_aggr.at(m)++;
+
+   if (!m_collect_aggr) return;
+
+   COUNTER("updateAggr");
+   const int N = U(m).rows();
+
+   #pragma omp parallel for schedule(static)
+   for (int i0 = 0; i0 < N; i0 += AGGR_BLOCK)
+      for (int i = i0; i < std::min(i0 + AGGR_BLOCK, N); ++i)
+         updateAggr(m, i);
+}
+
+std::shared_ptr<const Model> Model::snapshot(bool with_aggr) const
+{
+   COUNTER("snapshot");
+   auto ret = std::make_shared<Model>();
+   ret->m_factors = m_factors;
+   ret->m_link_matrices = m_link_matrices;
+   ret->m_mus = m_mus;
+   ret->m_num_latent = m_num_latent;
+   ret->m_dims = m_dims;
+   ret->m_save_model = m_save_model;
+   ret->m_num_aggr = m_num_aggr;
+   // predict() on the snapshot needs the active latent dimensions
+   ret->m_nonzero_cols = m_nonzero_cols;
+   ret->m_active = m_active;
+   ret->m_active_except = m_active_except;
+   ret->Pcache.init(Array1D::Ones(m_num_latent));
+   ret->m_collect_aggr = m_collect_aggr && with_aggr;
+   if (ret->m_collect_aggr)
+   {
+      ret->m_aggr_sum = m_aggr_sum;
+      ret->m_aggr_dot = m_aggr_dot;
+   }
+   return ret;
 }
 
 void Model::save(SaveState &sf) const
@@ -203,18 +314,40 @@ void Model::save(SaveState &sf) const
          else
          {
             // compute mean and precision (inverse of the covariance)
-            Matrix mu = Matrix::Zero(Usum.rows(), Usum.cols());
-            Matrix prec = Matrix::Zero(Uprod.rows(), Uprod.cols());
+            const int K = nlatent();
+            const int N = Usum.rows();
+            Matrix mu(N, K);
+            Matrix prec(N, K * K);
 
-            // calculate real mu and Lambda
-            for (int i = 0; i < U(m).rows(); i++)
+            COUNTER("post_mu_lambda");
+            #pragma omp parallel
             {
-               Vector sum = Usum.row(i);
-               Matrix prod = Eigen::Map<const Matrix>(Uprod.row(i).data(), nlatent(), nlatent());
-               Matrix prec_i = ((prod - (sum.transpose() * sum / n)) / (n - 1)).inverse();
-
-               prec.row(i) = Eigen::Map<Vector>(prec_i.data(), nlatent() * nlatent());
-               mu.row(i) = sum / n;
+               Matrix cov(K, K);
+               Eigen::LLT<Matrix> chol(K);
+
+               #pragma omp for schedule(static)
+               for (int i = 0; i < N; i++)
+               {
+                  const auto &sum = Usum.row(i);
+                  matrix_utils::unpack_symmetric(Uprod.row(i).data(), cov);
+                  cov.noalias() -= sum.transpose() * sum / n;
+                  cov /= (n - 1);
+
+                  Eigen::Map<Matrix> prec_i(prec.row(i).data(), K, K);
+                  chol.compute(cov);
+                  if (chol.info() == Eigen::Success)
+                  {
+                     prec_i.setIdentity();
+                     chol.solveInPlace(prec_i);
+                  }
+                  else
+                  {
+                     // not positive definite, e.g. too few samples
+                     prec_i = cov.inverse();
+                  }
+
+                  mu.row(i) = sum / n;
+               }
             }
 
             sf.putPostMuLambda(m, mu, prec);
@@ -224,6 +357,16 @@ void Model::save(SaveState &sf) const
 }
 
 void Model::restore(const SaveState &sf, int skip_mode)
+{
+   RestoreSelection select;
+   for (int m = 0; m < (int)sf.getNModes(); ++m)
+      if (m != skip_mode)
+         select.modes.push_back(m);
+
+   restore(sf, select);
+}
+
+void Model::restore(const SaveState &sf, const RestoreSelection &select)
 {
    unsigned nmodes = sf.getNModes();
    m_factors.clear();
@@ -236,19 +379,36 @@ void Model::restore(const SaveState &sf, int skip_mode)
 
    for (std::uint64_t i = 0; i < nmodes; ++i)
    {
-      if ((int)i != skip_mode)
+      const bool selected = select.modes.empty() ||
+         std::find(select.modes.begin(), select.modes.end(), (int)i) != select.modes.end();
+      const bool all_rows = i >= select.rows.size() || select.rows.at(i).empty();
+
+      if (selected)
       {
          auto &U = m_factors.at(i);
-         sf.readModel(i, U);
+         if (all_rows)
+            sf.readModel(i, U);
+         else
+            sf.readModel(i, U, select.rows.at(i));
          m_dims.at(i) = U.rows();
          m_num_latent = U.cols();
 
-         if (sf.hasAggr(i))
+         if (select.aggr && all_rows && sf.hasAggr(i))
          {
             int        &n = m_num_aggr.at(i);
             Matrix  &Usum = m_aggr_sum.at(i);
             Matrix &Uprod = m_aggr_dot.at(i);
             sf.readAggr(i, n, Usum, Uprod);
+
+            // older checkpoints store the full K x K product per row
+            const int K = m_num_latent;
+            if (Uprod.cols() == K * K && K > 1)
+            {
+               Matrix packed(Uprod.rows(), matrix_utils::packed_size(K));
+               for (int r = 0; r < Uprod.rows(); ++r)
+                  matrix_utils::pack_lower(Eigen::Map<const Matrix>(Uprod.row(r).data(), K, K), packed.row(r).data());
+               Uprod.swap(packed);
+            }
          }
       }
       else
@@ -267,6 +427,9 @@ void Model::restore(const SaveState &sf, int skip_mode)
    }
 
    Pcache.init(Array1D::Ones(m_num_latent));
+   resetActive();
+   for (unsigned m = 0; m < nmodes; ++m)
+      updateActive(m);
 }
 
 std::ostream& Model::info(std::ostream &os, std::string indent) const
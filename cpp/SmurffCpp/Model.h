@@ -31,6 +31,14 @@ class VMatrixIterator;
 template<class T>
 class ConstVMatrixIterator;
 
+// the parts of a saved step read by Model::restore
+struct RestoreSelection
+{
+   std::vector<int> modes;                     // latent matrices of these modes only, all if empty
+   std::vector<std::vector<std::size_t>> rows; // per mode: only these rows, in this order, all if empty
+   bool aggr = true;                           // posterior aggregates, of the modes read in full
+};
+
 class Model
 {
 private:
@@ -40,7 +48,7 @@ private:
 
    bool m_collect_aggr;
    std::vector<Matrix> m_aggr_sum; //vector of aggr summed m_factors matrices
-   std::vector<Matrix> m_aggr_dot; //vector of aggr dot m_factors matrices
+   std::vector<Matrix> m_aggr_dot; //vector of aggr dot m_factors matrices, packed lower triangle per row
    std::vector<int> m_num_aggr; //number of aggregated samples in above vectors
 
    int m_num_latent; //size of latent dimension for U matrices
@@ -49,6 +57,15 @@ private:
    // to make predictions faster
    mutable thread_vector<Array1D> Pcache;
 
+   // latent dimensions that are not all-zero (e.g. switched off by spike-and-slab)
+   // only rescanned by updateActive(m), after init() everything is active
+   std::vector<std::vector<bool>> m_nonzero_cols; // per mode
+   std::vector<int> m_active;                     // non-zero in all modes
+   std::vector<std::vector<int>> m_active_except; // non-zero in all modes but one
+
+   void resetActive();
+   void rebuildActive();
+
 public:
    Model();
 
@@ -113,14 +130,30 @@ public:
    SubModel full();
 
 public:
+   // rescan U(m) for all-zero latent dimensions, after U(m) has been resampled
+   void updateActive(int m);
+
+   // active latent dimensions, in all modes (except_mode == -1)
+   // or in all modes except except_mode
+   const std::vector<int> &active(int except_mode = -1) const;
+
+public:
+   // add U(m) to the aggregates, in one pass after mode m was sampled
    void updateAggr(int m);
+   // add row n of U(m) only
    void updateAggr(int m, int n);
 
 public:
+   // copy of everything save() and predict() need, aggregates only if with_aggr
+   std::shared_ptr<const Model> snapshot(bool with_aggr) const;
+
    // output to file
    void save(SaveState &sf) const;
    bool m_save_model = true;
    void restore(const SaveState &sf, int skip_mode = -1);
+   // the modes not selected get no rows (like skip_mode), a mode with a row
+   // selection has as many rows as selected: U(m).row(i) is row select.rows[m][i]
+   void restore(const SaveState &sf, const RestoreSelection &select);
 
    std::ostream& info(std::ostream &os, std::string indent) const;
    std::ostream& status(std::ostream &os, std::string indent) const;
@@ -166,6 +199,11 @@ public:
       return m_model.nlatent();
    }
 
+   const std::vector<int> &active(int except_mode = -1) const
+   {
+      return m_model.active(except_mode);
+   }
+
    //number of dimentions in train data
    std::uint64_t nmodes() const
    {
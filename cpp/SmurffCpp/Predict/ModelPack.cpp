@@ -0,0 +1,229 @@
+#include "ModelPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <SmurffCpp/Utils/SaveState.h>
+#include <SmurffCpp/Utils/counters.h>
+
+namespace bi = boost::interprocess;
+
+namespace smurff {
+
+static const char PACK_MAGIC[8] = {'S', 'M', 'U', 'R', 'F', 'F', 'P', 'K'};
+static const std::uint32_t PACK_VERSION = 1;
+
+// a page: every block can be mapped, advised or evicted on its own
+static const std::uint64_t PACK_ALIGNMENT = 4096;
+
+struct PackHeader
+{
+   char magic[8];
+   std::uint32_t version;
+   std::uint32_t scalar_bytes;
+   std::uint32_t nmodes;
+   std::uint32_t nsamples;
+   std::uint32_t num_latent;
+   std::uint32_t num_blocks;
+};
+
+static std::uint64_t align(std::uint64_t offset, std::uint64_t alignment)
+{
+   return (offset + alignment - 1) / alignment * alignment;
+}
+
+// offset of the block table, after the header, dims and sample numbers
+static std::uint64_t tableOffset(std::uint64_t nmodes, std::uint64_t nsamples)
+{
+   return align(sizeof(PackHeader) + nmodes * sizeof(std::uint64_t) + nsamples * sizeof(std::int32_t), sizeof(std::uint64_t));
+}
+
+static void pad(std::ofstream &out, std::uint64_t offset)
+{
+   static const char zeros[PACK_ALIGNMENT] = {0};
+   for (std::uint64_t pos = out.tellp(); pos < offset; pos = out.tellp())
+      out.write(zeros, std::min(offset - pos, PACK_ALIGNMENT));
+}
+
+static void writeMatrix(std::ofstream &out, const float_type *data, std::uint64_t size)
+{
+   out.write(reinterpret_cast<const char *>(data), size * sizeof(float_type));
+}
+
+void ModelPack::write(const std::string &path, const std::vector<SaveState> &steps)
+{
+   COUNTER("write model pack");
+   THROWERROR_ASSERT_MSG(!steps.empty(), "No samples to pack");
+
+   const int nmodes = steps.front().getNModes();
+   const int S = steps.size();
+
+   std::vector<std::uint64_t> dims(nmodes);
+   std::uint64_t K = 0;
+   for (int m = 0; m < nmodes; ++m)
+   {
+      auto shape = steps.front().getModelShape(m);
+      dims[m] = shape.at(0);
+      K = shape.at(1);
+   }
+
+   // every block has its place before the first one is written
+   std::vector<Block> blocks;
+   for (int m = 0; m < nmodes; ++m)
+      blocks.push_back({LATENTS, 0, (std::uint32_t)m, 0, 0, S * dims[m], K});
+
+   std::vector<std::int32_t> isample(S);
+   std::vector<std::vector<Matrix>> link_matrices(S, std::vector<Matrix>(nmodes));
+   std::vector<std::vector<Vector>> mus(S, std::vector<Vector>(nmodes));
+   for (int s = 0; s < S; ++s)
+   {
+      THROWERROR_ASSERT_MSG((int)steps[s].getNModes() == nmodes, "All samples should have the same number of modes");
+      isample[s] = steps[s].getIsample();
+
+      for (int m = 0; m < nmodes; ++m)
+      {
+         const Matrix &beta = link_matrices[s][m];
+         const Vector &mu = mus[s][m];
+         steps[s].readLinkMatrix(m, link_matrices[s][m]);
+         steps[s].readMu(m, mus[s][m]);
+         blocks.push_back({LINK_MATRIX, (std::uint32_t)s, (std::uint32_t)m, 0, 0, (std::uint64_t)beta.rows(), (std::uint64_t)beta.cols()});
+         blocks.push_back({MU, (std::uint32_t)s, (std::uint32_t)m, 0, 0, 1, (std::uint64_t)mu.size()});
+      }
+   }
+
+   std::uint64_t offset = tableOffset(nmodes, S) + blocks.size() * sizeof(Block);
+   for (auto &b : blocks)
+   {
+      b.offset = offset = align(offset, PACK_ALIGNMENT);
+      offset += b.rows * b.cols * sizeof(float_type);
+   }
+
+   std::ofstream out(path, std::ios::binary | std::ios::trunc);
+   THROWERROR_ASSERT_MSG(out, "Cannot open " + path);
+
+   PackHeader header;
+   std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+   header.version = PACK_VERSION;
+   header.scalar_bytes = sizeof(float_type);
+   header.nmodes = nmodes;
+   header.nsamples = S;
+   header.num_latent = K;
+   header.num_blocks = blocks.size();
+
+   out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+   out.write(reinterpret_cast<const char *>(dims.data()), dims.size() * sizeof(std::uint64_t));
+   out.write(reinterpret_cast<const char *>(isample.data()), isample.size() * sizeof(std::int32_t));
+   pad(out, tableOffset(nmodes, S));
+   out.write(reinterpret_cast<const char *>(blocks.data()), blocks.size() * sizeof(Block));
+
+   // one latent matrix in memory at a time
+   Matrix U;
+   for (const auto &b : blocks)
+   {
+      pad(out, b.offset);
+      const int s = b.sample;
+      const int m = b.mode;
+      switch (b.kind)
+      {
+      case LATENTS:
+         for (int k = 0; k < S; ++k)
+         {
+            steps[k].readModel(m, U);
+            THROWERROR_ASSERT_MSG((std::uint64_t)U.rows() == dims[m] && (std::uint64_t)U.cols() == K,
+                                  "All samples should have the same shape in mode " + std::to_string(m));
+            writeMatrix(out, U.data(), U.size());
+         }
+         break;
+      case LINK_MATRIX:
+         writeMatrix(out, link_matrices[s][m].data(), link_matrices[s][m].size());
+         break;
+      case MU:
+         writeMatrix(out, mus[s][m].data(), mus[s][m].size());
+         break;
+      }
+   }
+
+   out.flush();
+   THROWERROR_ASSERT_MSG(out.good(), "Error writing " + path);
+}
+
+bool ModelPack::isModelPack(const std::string &path)
+{
+   char magic[sizeof(PACK_MAGIC)];
+   std::ifstream in(path, std::ios::binary);
+   return in.read(magic, sizeof(magic)) && std::equal(magic, magic + sizeof(magic), PACK_MAGIC);
+}
+
+ModelPack::ModelPack(const std::string &path)
+{
+   COUNTER("open model pack");
+   THROWERROR_ASSERT_MSG(isModelPack(path), path + " is not a model pack");
+
+   // the mapping stays valid after the file_mapping is gone
+   bi::file_mapping file(path.c_str(), bi::read_only);
+   m_region = std::make_unique<bi::mapped_region>(file, bi::read_only);
+
+   const char *base = static_cast<const char *>(m_region->get_address());
+   const std::uint64_t size = m_region->get_size();
+
+   PackHeader header;
+   THROWERROR_ASSERT_MSG(size >= sizeof(header), "Truncated model pack " + path);
+   std::memcpy(&header, base, sizeof(header));
+   THROWERROR_ASSERT_MSG(header.version == PACK_VERSION, "Unsupported model pack version " + std::to_string(header.version));
+   THROWERROR_ASSERT_MSG(header.scalar_bytes == sizeof(float_type), "Model pack written with another float type");
+
+   const std::uint64_t table = tableOffset(header.nmodes, header.nsamples);
+   THROWERROR_ASSERT_MSG(table + header.num_blocks * sizeof(Block) <= size, "Truncated model pack " + path);
+
+   std::vector<std::uint64_t> dims(header.nmodes);
+   std::memcpy(dims.data(), base + sizeof(header), dims.size() * sizeof(std::uint64_t));
+   m_dims = PVec<>(dims);
+   m_num_latent = header.num_latent;
+
+   std::vector<std::int32_t> isample(header.nsamples);
+   std::memcpy(isample.data(), base + sizeof(header) + dims.size() * sizeof(std::uint64_t), isample.size() * sizeof(std::int32_t));
+   m_isample.assign(isample.begin(), isample.end());
+
+   m_blocks.resize(header.num_blocks);
+   std::memcpy(m_blocks.data(), base + table, m_blocks.size() * sizeof(Block));
+   for (const auto &b : m_blocks)
+      THROWERROR_ASSERT_MSG(b.offset + b.rows * b.cols * sizeof(float_type) <= size, "Truncated model pack " + path);
+}
+
+ModelPack::~ModelPack() {}
+
+const ModelPack::Block &ModelPack::block(BlockKind kind, int s, int m) const
+{
+   auto b = std::find_if(m_blocks.begin(), m_blocks.end(), [kind, s, m](const Block &b) {
+      return b.kind == (std::uint32_t)kind && b.sample == (std::uint32_t)s && b.mode == (std::uint32_t)m;
+   });
+   THROWERROR_ASSERT_MSG(b != m_blocks.end(), "No such block in the model pack");
+   return *b;
+}
+
+Eigen::Map<const Matrix> ModelPack::map(const Block &b) const
+{
+   const char *base = static_cast<const char *>(m_region->get_address());
+   return Eigen::Map<const Matrix>(reinterpret_cast<const float_type *>(base + b.offset), b.rows, b.cols);
+}
+
+Eigen::Map<const Matrix> ModelPack::latents(int m) const
+{
+   return map(block(LATENTS, 0, m));
+}
+
+void ModelPack::readLinkMatrix(int s, int m, Matrix &beta) const
+{
+   beta = map(block(LINK_MATRIX, s, m));
+}
+
+void ModelPack::readMu(int s, int m, Vector &mu) const
+{
+   mu = map(block(MU, s, m)).row(0);
+}
+
+} // end namespace smurff
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SmurffCpp/Types.h>
+#include <SmurffCpp/Utils/PVec.hpp>
+#include <SmurffCpp/Utils/Error.h>
+
+namespace boost { namespace interprocess { class mapped_region; } }
+
+namespace smurff {
+
+class SaveState;
+
+// The saved samples of a model in one flat binary file, mapped read-only
+// into memory: all processes scoring with the same pack share one copy of it
+// in the page cache, and opening it reads nothing but the header.
+//
+// Layout (native byte order):
+//   header: magic, version, sizeof(float_type), nmodes, nsamples, num_latent, num_blocks
+//   dims[nmodes] (uint64), isample[nsamples] (int32)
+//   block table: num_blocks x {kind, sample, mode, offset, rows, cols}
+//   blocks, every one aligned to PACK_ALIGNMENT bytes, row-major
+//
+// The latent matrices of mode m are one block of (nsamples * N_m) x K, sample s
+// in rows [s * N_m, (s + 1) * N_m), as in SampleEnsemble. Link matrices and mus
+// have a (small) block per sample and mode.
+class ModelPack
+{
+public:
+   // the latents, link matrices and mus of steps
+   static void write(const std::string &path, const std::vector<SaveState> &steps);
+
+   // true if path starts like a model pack
+   static bool isModelPack(const std::string &path);
+
+   ModelPack(const std::string &path);
+   ~ModelPack();
+
+   int nsamples() const { return m_isample.size(); }
+   int nmodes() const { return m_dims.size(); }
+   int nlatent() const { return m_num_latent; }
+   const PVec<> &getDims() const { return m_dims; }
+   int getIsample(int s) const { return m_isample.at(s); }
+
+   // the (nsamples * N_m) x K latent matrices of mode m, in the mapped file
+   Eigen::Map<const Matrix> latents(int m) const;
+
+   void readLinkMatrix(int s, int m, Matrix &) const;
+   void readMu(int s, int m, Vector &) const;
+
+private:
+   enum BlockKind { LATENTS = 1, LINK_MATRIX = 2, MU = 3 };
+
+   struct Block
+   {
+      std::uint32_t kind, sample, mode, reserved;
+      std::uint64_t offset, rows, cols;
+   };
+
+   const Block &block(BlockKind kind, int s, int m) const;
+   Eigen::Map<const Matrix> map(const Block &) const;
+
+   std::unique_ptr<boost::interprocess::mapped_region> m_region;
+
+   int m_num_latent = 0;
+   PVec<> m_dims = PVec<>(0);
+   std::vector<int> m_isample;
+   std::vector<Block> m_blocks;
+};
+
+} // end namespace smurff
@@ -1,8 +1,11 @@
+#include <algorithm>
 #include <memory>
+#include <numeric>
 
 #include <SmurffCpp/Types.h>
 #include <SmurffCpp/Types.h>
 
+#include <SmurffCpp/Utils/BackgroundWriter.h>
 #include <SmurffCpp/Utils/counters.h>
 #include <SmurffCpp/Utils/StateFile.h>
 #include <SmurffCpp/Utils/MatrixUtils.h>
@@ -12,30 +15,39 @@
 #include <SmurffCpp/Model.h>
 
 #include <SmurffCpp/Predict/PredictSession.h>
+#include <SmurffCpp/Predict/ModelPack.h>
+#include <SmurffCpp/Predict/ServingModel.h>
 
 namespace smurff
 {
 
+const std::string PREDICTIONS_SECTION = "predictions";
+const std::string PRED_AVG_DATASET = "pred_avg";
+const std::string PRED_VAR_DATASET = "pred_var";
+
+// a query touching less than this fraction of the rows of a mode reads only those rows
+static const int FEW_ROWS_DIVISOR = 8;
+
 PredictSession::PredictSession(const std::string &model_file)
     : ISession(Config()) //FIXME
-    , m_model_file(StateFile(model_file))
+    , m_model_path(model_file)
     , m_pred_savefile()
     , m_has_config(false)
     , m_num_latent(-1)
     , m_dims(PVec<>(0))
 {
-    m_stepfiles = m_model_file.openSampleSteps();
+    openModel();
 }
 
 PredictSession::PredictSession(const Config &config)
     : ISession(config)
-    , m_model_file(StateFile(config.getRestoreName()))
+    , m_model_path(config.getRestoreName())
     , m_pred_savefile(std::make_unique<StateFile>(config.getSaveName()))
     , m_has_config(true)
     , m_num_latent(-1)
     , m_dims(PVec<>(0))
 {
-    m_stepfiles = m_model_file.openSampleSteps();
+    openModel();
 }
 
 void PredictSession::run()
@@ -58,17 +70,22 @@ void PredictSession::run()
             std::make_pair(0, getConfig().getRowFeatures()) :
             std::make_pair(1, getConfig().getColFeatures()) ;
 
-        THROWERROR_ASSERT_MSG(!side_info.second.hasData(), "Need either test, row features or col features");
+        THROWERROR_ASSERT_MSG(side_info.second.hasData(), "Need either test, row features or col features");
+        THROWERROR_ASSERT_MSG(getConfig().getSaveName() != m_model_path,
+                              "Cannot have same output file for model and predictions - both have " + getConfig().getSaveName());
+
+        // the output file is rewritten as a whole
+        m_pred_savefile.reset();
 
         if (side_info.second.isDense())
         {
             const auto &dense_matrix = side_info.second.getDenseMatrixData();
-            predict(side_info.first, dense_matrix, getConfig().getSaveFreq());
+            predict_stream(side_info.first, dense_matrix, getConfig().getSaveName());
         }
         else
         {
             const auto &sparse_matrix = side_info.second.getSparseMatrixData();
-            predict(side_info.first, sparse_matrix, getConfig().getSaveFreq());
+            predict_stream(side_info.first, sparse_matrix, getConfig().getSaveName());
         }
     }
 }
@@ -79,11 +96,12 @@ void PredictSession::init()
     THROWERROR_ASSERT(getConfig().getTest().hasData());
     m_result = Result(getConfig().getTest(), getConfig().getNSamples());
 
-    m_pos = m_stepfiles.rbegin();
+    // last sample first
+    m_pos = ensemble().nsamples() - 1;
     m_iter = 0;
     m_is_init = true;
 
-    THROWERROR_ASSERT_MSG(getConfig().getSaveName() != m_model_file.getPath(),
+    THROWERROR_ASSERT_MSG(getConfig().getSaveName() != m_model_path,
                           "Cannot have same output file for model and predictions - both have " + getConfig().getSaveName());
 
     if (getConfig().getSaveFreq())
@@ -100,12 +118,10 @@ bool PredictSession::step()
 {
     THROWERROR_ASSERT(m_has_config);
     THROWERROR_ASSERT(m_is_init);
-    THROWERROR_ASSERT(m_pos != m_stepfiles.rend());
+    THROWERROR_ASSERT(m_pos >= 0);
 
     double start = tick();
-    Model model;
-    restoreModel(model, *m_pos);
-    m_result.update(model, false);
+    m_result.update(m_ensemble, m_pos, false);
     double stop = tick();
     m_iter++;
     m_secs_per_iter = stop - start;
@@ -117,37 +133,37 @@ bool PredictSession::step()
     if (getConfig().getSaveFreq() > 0 && (m_iter % getConfig().getSaveFreq()) == 0)
         save();
 
-    auto next_pos = m_pos;
-    next_pos++;
-    bool last_iter = next_pos == m_stepfiles.rend();
+    bool last_iter = m_pos == 0;
 
     //save last iter
     if (last_iter && getConfig().getSaveFreq() == -1)
         save();
 
-    m_pos++;
+    m_pos--;
     return !last_iter;
 }
 
 void PredictSession::save()
 {
-    //save this iteration
-    SaveState saveState = m_pred_savefile->createSampleStep(m_iter, false);
-
     if (getConfig().getVerbose())
     {
         std::cout << "-- Saving predictions into '" << m_pred_savefile->getPath() << "'." << std::endl;
     }
 
-    m_result.save(saveState);
+    //save this iteration
+    {
+        SaveState saveState = m_pred_savefile->createSampleStep(m_iter, false);
+        m_result.save(saveState);
+    }
+    m_pred_savefile->indexSampleStep(m_iter);
 }
 
 StatusItem PredictSession::getStatus() const
 {
     StatusItem ret;
     ret.phase = "Predict";
-    ret.iter = m_pos->getIsample();
-    ret.phase_iter = m_stepfiles.size();
+    ret.iter = m_ensemble.getIsample(std::max(m_pos, 0));
+    ret.phase_iter = m_ensemble.nsamples();
 
     ret.train_rmse = NAN;
 
@@ -172,7 +188,7 @@ std::ostream &PredictSession::info(std::ostream &os, std::string indent) const
 {
     os << indent << "PredictSession {\n";
     os << indent << "  Model {\n";
-    os << indent << "    model-file: " << m_model_file.getPath() << "\n";
+    os << indent << "    model-file: " << m_model_path << "\n";
     os << indent << "    num-samples: " << getNumSteps() << "\n";
     os << indent << "    num-latent: " << getNumLatent() << "\n";
     os << indent << "    dimensions: " << getModelDims() << "\n";
@@ -198,6 +214,22 @@ std::ostream &PredictSession::info(std::ostream &os, std::string indent) const
     return os;
 }
 
+const SampleEnsemble &PredictSession::ensemble()
+{
+    if (m_ensemble.empty() && !m_sample_numbers.empty())
+        loadEnsemble();
+
+    return m_ensemble;
+}
+
+void PredictSession::loadEnsemble(const std::vector<int> &select)
+{
+    m_ensemble.load(openSteps(select));
+
+    m_num_latent = m_ensemble.nlatent();
+    m_dims = m_ensemble.getDims();
+}
+
 void PredictSession::restoreModel(Model &model, const SaveState &sf, int skip_mode)
 {
     model.restore(sf, skip_mode);
@@ -218,7 +250,89 @@ void PredictSession::restoreModel(Model &model, const SaveState &sf, int skip_mo
 
 void PredictSession::restoreModel(Model &model, int i, int skip_mode)
 {
-    restoreModel(model, m_stepfiles.at(i), skip_mode);
+    restoreModel(model, modelFile().openSampleStep(m_sample_numbers.at(i)), skip_mode);
+}
+
+void PredictSession::openModel()
+{
+    if (ModelPack::isModelPack(m_model_path))
+    {
+        auto pack = std::make_shared<const ModelPack>(m_model_path);
+        m_ensemble.load(pack);
+        for (int s = 0; s < pack->nsamples(); ++s)
+            m_sample_numbers.push_back(pack->getIsample(s));
+
+        m_num_latent = pack->nlatent();
+        m_dims = pack->getDims();
+        return;
+    }
+
+    m_model_file = std::make_unique<StateFile>(m_model_path);
+    m_sample_numbers = m_model_file->getSampleNumbers();
+    readModelDims();
+}
+
+const StateFile &PredictSession::modelFile() const
+{
+    THROWERROR_ASSERT_MSG(m_model_file, "Not available with the model pack " + m_model_path);
+    return *m_model_file;
+}
+
+void PredictSession::readModelDims()
+{
+    if (m_sample_numbers.empty())
+        return;
+
+    SaveState sf = modelFile().openSampleStep(m_sample_numbers.front());
+    m_dims = PVec<>(sf.getNModes());
+    for (int m = 0; m < (int)m_dims.size(); ++m)
+    {
+        auto shape = sf.getModelShape(m);
+        m_dims.at(m) = shape.at(0);
+        m_num_latent = shape.at(1);
+    }
+}
+
+bool PredictSession::selectRows(std::vector<PVec<>> &coords, std::vector<std::vector<std::size_t>> &rows) const
+{
+    rows.assign(m_dims.size(), std::vector<std::size_t>());
+
+    bool ret = false;
+    for (int m = 0; m < (int)m_dims.size(); ++m)
+    {
+        std::vector<std::size_t> touched;
+        touched.reserve(coords.size());
+        for (const auto &pos : coords)
+            touched.push_back(pos.at(m));
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+        if (touched.size() * FEW_ROWS_DIVISOR >= (std::size_t)m_dims.at(m))
+            continue;
+
+        for (auto &pos : coords)
+            pos.at(m) = std::lower_bound(touched.begin(), touched.end(), (std::size_t)pos.at(m)) - touched.begin();
+        rows.at(m).swap(touched);
+        ret = true;
+    }
+
+    return ret;
+}
+
+std::vector<SaveState> PredictSession::openSteps(const std::vector<int> &select) const
+{
+    std::vector<SaveState> steps;
+    if (select.empty())
+    {
+        for (int isample : m_sample_numbers)
+            steps.push_back(modelFile().openSampleStep(isample));
+    }
+    else
+    {
+        for (int i : select)
+            steps.push_back(modelFile().openSampleStep(m_sample_numbers.at(i)));
+    }
+    return steps;
 }
 
 // predict one element
@@ -232,19 +346,24 @@ ResultItem PredictSession::predict(PVec<> pos, const SaveState &sf)
 // predict one element
 void PredictSession::predict(ResultItem &res, const SaveState &sf)
 {
-    Model model;
-    model.restore(sf);
-    auto pred = model.predict(res.coords);
-    res.update(pred);
+    // only read the row at res.coords of every latent matrix
+    Array1D P;
+    Matrix row;
+    for (unsigned d = 0; d < sf.getNModes(); ++d)
+    {
+        sf.readModel(d, row, res.coords.at(d), 1);
+        if (d == 0)
+            P = row.row(0).array();
+        else
+            P *= row.row(0).array();
+    }
+    res.update(P.sum());
 }
 
 // predict one element
 void PredictSession::predict(ResultItem &res)
 {
-    auto stepfiles = m_model_file.openSampleSteps();
-
-    for (const auto &sf : stepfiles)
-        predict(res, sf);
+    ensemble().predict(res);
 }
 
 ResultItem PredictSession::predict(PVec<> pos)
@@ -259,14 +378,115 @@ std::shared_ptr<Result> PredictSession::predict(const DataConfig &Y)
 {
     auto res = std::make_shared<Result>(Y);
 
-    for (const auto &s : m_stepfiles)
+    // all samples at once
+    std::vector<PVec<>> coords;
+    coords.reserve(res->m_predictions.size());
+    for (const auto &item : res->m_predictions)
+        coords.push_back(item.coords);
+
+    // without loading all rows of all samples
+    std::vector<std::vector<std::size_t>> rows;
+    if (m_ensemble.empty() && !m_sample_numbers.empty() && selectRows(coords, rows))
+    {
+        SampleEnsemble few;
+        few.load(openSteps(), std::vector<int>(), rows);
+        res->update(few.predict_batch(coords), few.nsamples());
+        return res;
+    }
+
+    res->update(predict_batch(coords), ensemble().nsamples());
+
+    return res;
+}
+
+std::shared_ptr<Result> PredictSession::predict(const DataConfig &Y, int block_samples)
+{
+    COUNTER("predict blocks");
+    THROWERROR_ASSERT_MSG(block_samples > 0, "Need at least one sample per block");
+    THROWERROR_ASSERT_MSG(!m_sample_numbers.empty(), "No samples to predict from");
+
+    // all samples are mapped already
+    if (!m_model_file)
+        return predict(Y);
+
+    auto res = std::make_shared<Result>(Y);
+
+    std::vector<PVec<>> coords;
+    coords.reserve(res->m_predictions.size());
+    for (const auto &item : res->m_predictions)
+        coords.push_back(item.coords);
+
+    std::vector<std::vector<std::size_t>> rows;
+    selectRows(coords, rows);
+
+    const int S = m_sample_numbers.size();
+    auto load = [this, S, block_samples, &rows](SampleEnsemble &block, int first) {
+        std::vector<int> select(std::min(block_samples, S - first));
+        std::iota(select.begin(), select.end(), first);
+        block.load(openSteps(select), std::vector<int>(), rows);
+    };
+
+    // double buffered, only the reader thread touches the files
+    SampleEnsemble blocks[2];
+    BackgroundWriter reader(1);
+    reader.push([&] { load(blocks[0], 0); });
+
+    for (int b = 0, first = 0; first < S; ++b, first += block_samples)
     {
-        Model model;
-        restoreModel(model, s);
-        res->update(model, false);
+        reader.flush();
+        const SampleEnsemble &current = blocks[b % 2];
+        if (first + block_samples < S)
+            reader.push([&, b, first] { load(blocks[(b + 1) % 2], first + block_samples); });
+
+        if (getConfig().getVerbose())
+            std::cout << "Predicting samples " << first << "-" << first + current.nsamples() << "/" << S << "." << std::endl;
+
+        res->merge(current.predict_batch(coords), current.nsamples());
     }
 
     return res;
 }
 
+BatchPrediction PredictSession::predict_batch(const std::vector<PVec<>> &coords, const std::vector<double> &quantiles)
+{
+    return ensemble().predict_batch(coords, quantiles);
+}
+
+BatchPrediction PredictSession::predict_batch(const std::vector<int> &rows, const std::vector<int> &cols, const std::vector<double> &quantiles)
+{
+    return ensemble().predict_batch(rows, cols, quantiles);
+}
+
+void PredictSession::saveServingModel(const std::string &path, int bits, int var_rank)
+{
+    ServingModel serving;
+    serving.build(openSteps(), var_rank);
+    serving.save(path, bits);
+}
+
+void PredictSession::saveModelPack(const std::string &path)
+{
+    ModelPack::write(path, openSteps());
+}
+
+Recommendations PredictSession::topN(int mode, const std::vector<int> &rows, int N)
+{
+    return ensemble().topN(mode, rows, N);
+}
+
+Recommendations PredictSession::topN(const FoldedRows &rows, int N)
+{
+    return ensemble().topN(rows, N);
+}
+
+FoldedRows PredictSession::foldIn(int mode, const SparseMatrix &Y, double alpha)
+{
+    return ensemble().foldIn(mode, Y, alpha);
+}
+
+BatchPrediction PredictSession::predict_batch(const FoldedRows &rows, const std::vector<int> &cols, const std::vector<double> &quantiles)
+{
+    return ensemble().predict_batch(rows, cols, quantiles);
+}
+
 } // end namespace smurff
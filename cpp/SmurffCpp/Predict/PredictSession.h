@@ -10,6 +10,7 @@
 #include <SmurffCpp/Sessions/ISession.h>
 #include <SmurffCpp/Model.h>
 #include <SmurffCpp/result.h>
+#include <SmurffCpp/Predict/SampleEnsemble.h>
 
 
 namespace smurff {
@@ -17,34 +18,64 @@ namespace smurff {
 class Result;
 struct ResultItem;
 
+// layout of the files written by PredictSession::predict_stream
+extern const std::string PREDICTIONS_SECTION;
+extern const std::string PRED_AVG_DATASET;
+extern const std::string PRED_VAR_DATASET;
+
 class PredictSession : public ISession
 {
 private:
-    StateFile m_model_file;
+    std::string m_model_path;
+    std::unique_ptr<StateFile> m_model_file; // none for a model pack
     std::unique_ptr<StateFile> m_pred_savefile;
     bool m_has_config;
 
     Result m_result;
-    std::vector<SaveState>::reverse_iterator m_pos;
+    int m_pos; // sample in m_ensemble of the next step()
 
     double m_secs_per_iter;
     double m_secs_total;
     int m_iter;
 
-    std::vector<SaveState> m_stepfiles;
+    // sample numbers of the steps in the model file, opened on use
+    std::vector<int> m_sample_numbers;
+
+    // the sample steps, in memory, loaded on first use (or mapped from a pack)
+    SampleEnsemble m_ensemble;
 
     int m_num_latent;
     PVec<> m_dims;
 
 private:
+    // the HDF5 state file or the model pack at m_model_path
+    void openModel();
+    const StateFile &modelFile() const;
+
     void restoreModel(Model &, const SaveState &, int skip_mode = -1);
     void restoreModel(Model &, int i, int skip_mode = -1);
 
+    // steps i for i in select, all steps if select is empty
+    std::vector<SaveState> openSteps(const std::vector<int> &select = std::vector<int>()) const;
+
+    // m_num_latent and m_dims from the shapes in the first step
+    void readModelDims();
+
+    // rows[m] = the rows of mode m in coords if they are few, and coords
+    // renumbered to match (see SampleEnsemble::load), false if no mode has few
+    bool selectRows(std::vector<PVec<>> &coords, std::vector<std::vector<std::size_t>> &rows) const;
+
 public:
-    int    getNumSteps()  const { return m_stepfiles.size(); } 
+    int    getNumSteps()  const { return m_sample_numbers.size(); } 
     int    getNumLatent() const { return m_num_latent; } 
     PVec<> getModelDims() const { return m_dims; } 
 
+    // all samples (or the selected steps only, see loadEnsemble)
+    const SampleEnsemble &ensemble();
+
+    // keep only step i for i in select in memory, all if select is empty
+    void loadEnsemble(const std::vector<int> &select = std::vector<int>());
+
 public:
     // ISession interface 
     void run() override;
@@ -73,30 +104,103 @@ private:
     void predict(ResultItem &, const SaveState &sf);
 
     // predict all elements in Ytest
+    // when they are in few rows of a mode, only those rows are read
     std::shared_ptr<Result> predict(const DataConfig &Y);
+    // same, block_samples samples in memory at a time: the next block is read
+    // in the background while the current one is scored
+    std::shared_ptr<Result> predict(const DataConfig &Y, int block_samples);
+
+    // mean, variance and quantiles (0 <= q <= 1) over all samples at once
+    BatchPrediction predict_batch(const std::vector<PVec<>> &coords, const std::vector<double> &quantiles = std::vector<double>());
+    // for the dense block rows x cols of a matrix, in row-major order
+    BatchPrediction predict_batch(const std::vector<int> &rows, const std::vector<int> &cols, const std::vector<double> &quantiles = std::vector<double>());
     void predict(Result &, const SaveState &);
 
+    // write the posterior mean model for serving, see ServingModel
+    void saveServingModel(const std::string &path, int bits = 0, int var_rank = 0);
+
+    // write all samples as a model pack, a PredictSession on path maps them
+    // into memory instead of reading them, see ModelPack
+    void saveModelPack(const std::string &path);
+
+    // new rows of mode with observations Y, see SampleEnsemble::foldIn
+    FoldedRows foldIn(int mode, const SparseMatrix &Y, double alpha);
+    template <class Feat>
+    FoldedRows foldIn(int mode, const SparseMatrix &Y, const Feat &f, double alpha)
+    {
+        return ensemble().foldIn(mode, Y, f, alpha);
+    }
+    BatchPrediction predict_batch(const FoldedRows &rows, const std::vector<int> &cols, const std::vector<double> &quantiles = std::vector<double>());
+
+    // the N best items of the other mode for each of rows in mode, see SampleEnsemble::topN
+    Recommendations topN(int mode, const std::vector<int> &rows, int N);
+    Recommendations topN(const FoldedRows &rows, int N);
+    // same, for new rows described by the side info in f
+    template <class Feat>
+    Recommendations topN(int mode, const Feat &f, int N, int chunk_rows = SampleEnsemble::DEFAULT_CHUNK_ROWS)
+    {
+        return ensemble().topN(mode, f, N, chunk_rows);
+    }
+
     // predict element or elements based on sideinfo
     template <class Feat>
     std::shared_ptr<Matrix> predict(int mode, const Feat &f, int save_freq = 0);
+
+    // entries with a row of features f in mode, see SampleEnsemble::predict_batch
+    template <class Feat>
+    BatchPrediction predict_batch(int mode, const Feat &f, const std::vector<PVec<>> &coords, int chunk_rows = SampleEnsemble::DEFAULT_CHUNK_ROWS)
+    {
+        return ensemble().predict_batch(mode, f, coords, chunk_rows);
+    }
+
+    // all entries of the rows of features f in mode, chunk_rows rows at a time
+    // written to datasets pred_avg and pred_var (see SampleEnsemble::predict_rows
+    // for the columns) of the HDF5 file path
+    template <class Feat>
+    void predict_stream(int mode, const Feat &f, const std::string &path, int chunk_rows = SampleEnsemble::DEFAULT_CHUNK_ROWS);
 };
 
+template <class Feat>
+void PredictSession::predict_stream(int mode, const Feat &f, const std::string &path, int chunk_rows)
+{
+    const SampleEnsemble &samples = ensemble();
+
+    std::size_t cols = 1;
+    for (int m = 0; m < samples.nmodes(); ++m)
+        if (m != mode)
+            cols *= samples.getDims().at(m);
+
+    h5::File file(path, h5::File::Overwrite);
+    HDF5Group out(file.getGroup("/"));
+    out.createDense(PREDICTIONS_SECTION, PRED_AVG_DATASET, f.rows(), cols);
+    out.createDense(PREDICTIONS_SECTION, PRED_VAR_DATASET, f.rows(), cols);
+
+    samples.predict_rows(mode, f, [&](int first_row, const Matrix &mean, const Matrix &var) {
+        if (getConfig().getVerbose())
+            std::cout << "Out-of-matrix prediction rows " << first_row << "-" << first_row + mean.rows() << "/" << f.rows() << "." << std::endl;
+
+        out.writeRows(PREDICTIONS_SECTION, PRED_AVG_DATASET, first_row, mean);
+        out.writeRows(PREDICTIONS_SECTION, PRED_VAR_DATASET, first_row, var);
+    }, chunk_rows);
+
+    file.flush();
+}
+
 // predict element or elements based on sideinfo
 template <class Feat>
 std::shared_ptr<Matrix> PredictSession::predict(int mode, const Feat &f, int save_freq)
 {
     std::shared_ptr<Matrix> average(nullptr);
+    const SampleEnsemble &samples = ensemble();
 
-    for (int step = 0; step < getNumSteps(); step++)
+    for (int step = 0; step < samples.nsamples(); step++)
     {
         if (getConfig().getVerbose())
         {
-            std::cout << "Out-of-matrix prediction step " << step << "/" << getNumSteps() << "." << std::endl;
+            std::cout << "Out-of-matrix prediction step " << step << "/" << samples.nsamples() << "." << std::endl;
         }
  
-        Model model;
-        restoreModel(model, step, mode);
-        auto predictions = model.predict(mode, f);
+        auto predictions = samples.predict(step, mode, f);
         if (!average)
             average = std::make_shared<Matrix>(predictions);
         else
@@ -114,7 +218,7 @@ std::shared_ptr<Matrix> PredictSession::predict(int mode, const Feat &f, int sav
         }
     }
 
-    (*average) /= (double)getNumSteps();
+    (*average) /= (double)samples.nsamples();
 
     if (save_freq != 0)
     {
@@ -0,0 +1,709 @@
+#include "SampleEnsemble.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <SmurffCpp/Predict/ModelPack.h>
+#include <SmurffCpp/Priors/NormalPrior.h>
+#include <SmurffCpp/Utils/SaveState.h>
+#include <SmurffCpp/Utils/counters.h>
+#include <SmurffCpp/ResultItem.h>
+
+namespace smurff {
+
+void SampleEnsemble::load(const std::vector<SaveState> &steps, const std::vector<int> &select,
+                          const std::vector<std::vector<std::size_t>> &rows)
+{
+   COUNTER("load ensemble");
+
+   std::vector<int> idx(select);
+   if (idx.empty())
+   {
+      idx.resize(steps.size());
+      std::iota(idx.begin(), idx.end(), 0);
+   }
+
+   m_nsamples = idx.size();
+   m_isample.clear();
+   m_stacked.clear();
+   m_lambdas.clear();
+   m_latents.clear();
+   m_pack.reset();
+   m_pack_latents.clear();
+   m_link_matrices.assign(m_nsamples, std::vector<Matrix>());
+   m_mus.assign(m_nsamples, std::vector<Vector>());
+
+   Matrix U;
+   for (int s = 0; s < m_nsamples; ++s)
+   {
+      const SaveState &sf = steps.at(idx[s]);
+      const int nmodes = sf.getNModes();
+
+      if (s == 0)
+      {
+         m_dims = PVec<>(nmodes);
+         m_latents.resize(nmodes);
+      }
+      THROWERROR_ASSERT(nmodes == (int)m_latents.size());
+
+      for (int m = 0; m < nmodes; ++m)
+      {
+         if (m < (int)rows.size() && !rows[m].empty())
+            sf.readModel(m, U, rows[m]);
+         else
+            sf.readModel(m, U);
+         if (s == 0)
+         {
+            m_dims.at(m) = U.rows();
+            m_num_latent = U.cols();
+            m_latents.at(m).resize((Eigen::Index)m_nsamples * U.rows(), U.cols());
+         }
+         THROWERROR_ASSERT(U.rows() == m_dims.at(m) && U.cols() == m_num_latent);
+         m_latents.at(m).middleRows((Eigen::Index)s * U.rows(), U.rows()) = U;
+      }
+
+      m_link_matrices.at(s).resize(nmodes);
+      m_mus.at(s).resize(nmodes);
+      for (int m = 0; m < nmodes; ++m)
+      {
+         sf.readLinkMatrix(m, m_link_matrices.at(s).at(m));
+         sf.readMu(m, m_mus.at(s).at(m));
+      }
+
+      m_isample.push_back(sf.getIsample());
+   }
+}
+
+void SampleEnsemble::load(std::shared_ptr<const ModelPack> pack)
+{
+   COUNTER("load ensemble");
+
+   m_nsamples = pack->nsamples();
+   m_num_latent = pack->nlatent();
+   m_dims = pack->getDims();
+   m_isample.clear();
+   m_stacked.clear();
+   m_lambdas.clear();
+   m_latents.clear();
+
+   m_pack_latents.clear();
+   for (int m = 0; m < pack->nmodes(); ++m)
+      m_pack_latents.push_back(pack->latents(m).data());
+
+   // small, copied
+   m_link_matrices.assign(m_nsamples, std::vector<Matrix>(pack->nmodes()));
+   m_mus.assign(m_nsamples, std::vector<Vector>(pack->nmodes()));
+   for (int s = 0; s < m_nsamples; ++s)
+   {
+      for (int m = 0; m < pack->nmodes(); ++m)
+      {
+         pack->readLinkMatrix(s, m, m_link_matrices.at(s).at(m));
+         pack->readMu(s, m, m_mus.at(s).at(m));
+      }
+      m_isample.push_back(pack->getIsample(s));
+   }
+
+   m_pack = pack;
+}
+
+double SampleEnsemble::predict(int s, const PVec<> &pos) const
+{
+   if (nmodes() == 2)
+      return row(s, 0, pos[0]).dot(row(s, 1, pos[1]));
+
+   Array1D P = row(s, 0, pos[0]).array();
+   for (int m = 1; m < nmodes(); ++m)
+      P *= row(s, m, pos[m]).array();
+   return P.sum();
+}
+
+void SampleEnsemble::predict(ResultItem &res) const
+{
+   for (int s = 0; s < m_nsamples; ++s)
+      res.update(predict(s, res.coords));
+}
+
+static BatchPrediction makeBatch(int num_entries, int num_quantiles)
+{
+   BatchPrediction ret;
+   ret.mean.resize(num_entries);
+   ret.var.resize(num_entries);
+   ret.last.resize(num_entries);
+   ret.quantiles.assign(num_quantiles, Vector(num_entries));
+   return ret;
+}
+
+// statistics of the n predictions in p for entry e, reorders p
+static void summarize(float_type *p, int n, const std::vector<double> &quantiles, BatchPrediction &out, int e)
+{
+   out.last(e) = p[n - 1];
+
+   const double mean = std::accumulate(p, p + n, 0.0) / n;
+   double se = 0.0;
+   for (int s = 0; s < n; ++s)
+      se += (p[s] - mean) * (p[s] - mean);
+
+   out.mean(e) = mean;
+   out.var(e) = n > 1 ? se / (n - 1) : 0.0;
+
+   // linear interpolation between the closest ranks
+   for (std::size_t i = 0; i < quantiles.size(); ++i)
+   {
+      const double h = (n - 1) * quantiles[i];
+      const int lo = std::floor(h);
+      std::nth_element(p, p + lo, p + n);
+      double value = p[lo];
+      if (h > lo)
+         value += (h - lo) * (*std::min_element(p + lo + 1, p + n) - p[lo]);
+      out.quantiles[i](e) = value;
+   }
+}
+
+BatchPrediction SampleEnsemble::predict_batch(const std::vector<PVec<>> &coords, const std::vector<double> &quantiles) const
+{
+   COUNTER("predict batch");
+   THROWERROR_ASSERT_MSG(!empty(), "No samples to predict from");
+
+   const int E = coords.size();
+   const int S = m_nsamples;
+   BatchPrediction ret = makeBatch(E, quantiles.size());
+
+   if (nmodes() != 2)
+   {
+      #pragma omp parallel
+      {
+         std::vector<float_type> p(S);
+
+         #pragma omp for schedule(guided)
+         for (int e = 0; e < E; ++e)
+         {
+            for (int s = 0; s < S; ++s)
+               p[s] = predict(s, coords[e]);
+            summarize(p.data(), S, quantiles, ret, e);
+         }
+      }
+      return ret;
+   }
+
+   // entries in the same row of mode 0 share its latent vector:
+   // one matrix-vector product per sample and row
+   std::vector<int> order(E);
+   std::iota(order.begin(), order.end(), 0);
+   std::stable_sort(order.begin(), order.end(), [&coords](int a, int b) { return coords[a][0] < coords[b][0]; });
+
+   std::vector<int> starts;
+   for (int k = 0; k < E; ++k)
+      if (k == 0 || coords[order[k]][0] != coords[order[k - 1]][0])
+         starts.push_back(k);
+   starts.push_back(E);
+   const int num_rows = starts.size() - 1;
+
+   #pragma omp parallel
+   {
+      Matrix P; // entries x samples
+      std::vector<int> cols;
+
+      #pragma omp for schedule(dynamic, 1)
+      for (int g = 0; g < num_rows; ++g)
+      {
+         const int begin = starts[g];
+         const int n = starts[g + 1] - begin;
+         const int i = coords[order[begin]][0];
+
+         cols.resize(n);
+         for (int k = 0; k < n; ++k)
+            cols[k] = coords[order[begin + k]][1];
+
+         P.resize(n, S);
+         for (int s = 0; s < S; ++s)
+            P.col(s).noalias() = U(s, 1)(cols, Eigen::all) * row(s, 0, i).transpose();
+
+         for (int k = 0; k < n; ++k)
+            summarize(P.row(k).data(), S, quantiles, ret, order[begin + k]);
+      }
+   }
+
+   return ret;
+}
+
+template <typename F>
+BatchPrediction SampleEnsemble::predict_block(int E, const std::vector<double> &quantiles, F block) const
+{
+   const int S = m_nsamples;
+   BatchPrediction ret = makeBatch(E, quantiles.size());
+
+   Matrix P(E, S); // entries x samples
+
+   #pragma omp parallel
+   {
+      Matrix out;
+
+      #pragma omp for schedule(dynamic, 1)
+      for (int s = 0; s < S; ++s)
+      {
+         block(s, out);
+         P.col(s) = Eigen::Map<const Eigen::Matrix<float_type, Eigen::Dynamic, 1>>(out.data(), E);
+      }
+
+      #pragma omp for schedule(static)
+      for (int e = 0; e < E; ++e)
+         summarize(P.row(e).data(), S, quantiles, ret, e);
+   }
+
+   return ret;
+}
+
+BatchPrediction SampleEnsemble::predict_batch(const std::vector<int> &rows, const std::vector<int> &cols, const std::vector<double> &quantiles) const
+{
+   COUNTER("predict batch");
+   THROWERROR_ASSERT_MSG(!empty(), "No samples to predict from");
+   THROWERROR_ASSERT_MSG(nmodes() == 2, "Only implemented for modes == 2");
+
+   return predict_block(rows.size() * cols.size(), quantiles, [&](int s, Matrix &out) {
+      out.noalias() = U(s, 0)(rows, Eigen::all) * U(s, 1)(cols, Eigen::all).transpose();
+   });
+}
+
+BatchPrediction SampleEnsemble::predict_batch(const FoldedRows &rows, const std::vector<int> &cols, const std::vector<double> &quantiles) const
+{
+   COUNTER("predict batch");
+   THROWERROR_ASSERT_MSG(!empty(), "No samples to predict from");
+   THROWERROR_ASSERT_MSG(nmodes() == 2, "Only implemented for modes == 2");
+
+   const int K = nlatent();
+   const int other = (rows.mode + 1) % 2;
+   return predict_block(rows.latents.rows() * cols.size(), quantiles, [&](int s, Matrix &out) {
+      out.noalias() = rows.latents.middleCols((Eigen::Index)s * K, K) * U(s, other)(cols, Eigen::all).transpose();
+   });
+}
+
+const std::vector<Matrix> &SampleEnsemble::lambdas(int mode) const
+{
+   if (m_lambdas.empty())
+      m_lambdas.resize(nmodes());
+
+   // not saved with the samples, estimated from the latents of each sample
+   auto &ret = m_lambdas.at(mode);
+   if (ret.empty())
+   {
+      COUNTER("estimate Lambda");
+      ret.resize(m_nsamples);
+      #pragma omp parallel for schedule(dynamic, 1)
+      for (int s = 0; s < m_nsamples; ++s)
+         ret[s] = NormalPrior::posterior_mean_Lambda(U(s, mode));
+   }
+
+   return ret;
+}
+
+FoldedRows SampleEnsemble::foldIn(int mode, const SparseMatrix &Y, double alpha) const
+{
+   const int K = nlatent();
+   Matrix M(Y.rows(), (Eigen::Index)m_nsamples * K);
+   for (int s = 0; s < m_nsamples; ++s)
+      M.middleCols((Eigen::Index)s * K, K).rowwise() = getMu(s, mode);
+
+   return foldIn(mode, Y, std::move(M), alpha);
+}
+
+FoldedRows SampleEnsemble::foldIn(int mode, const SparseMatrix &Y, Matrix M, double alpha) const
+{
+   COUNTER("fold in");
+   THROWERROR_ASSERT_MSG(!empty(), "No samples to fold in");
+   THROWERROR_ASSERT_MSG(nmodes() == 2, "Only implemented for modes == 2");
+   THROWERROR_ASSERT_MSG(alpha > 0, "Noise precision should be positive");
+
+   const int other = (mode + 1) % 2;
+   THROWERROR_ASSERT_MSG(Y.cols() == m_dims.at(other),
+      "Observations should have " + std::to_string(m_dims.at(other)) + " columns");
+
+   const int S = m_nsamples;
+   const int K = nlatent();
+   const int R = Y.rows();
+   const auto &Lambda = lambdas(mode);
+
+   FoldedRows ret;
+   ret.mode = mode;
+   ret.latents.swap(M);
+
+   #pragma omp parallel
+   {
+      Vector rr(K);
+      Matrix MM(K, K);
+
+      // the other mode and the prior are fixed: the conditional of each new
+      // row is exact, one draw per sample needs no burnin
+      #pragma omp for schedule(dynamic, 16)
+      for (int i = 0; i < S * R; ++i)
+      {
+         const int s = i / R;
+         const int r = i % R;
+         auto u = ret.latents.block(r, (Eigen::Index)s * K, 1, K);
+
+         // as NormalPrior::sample_latent
+         MM = Lambda[s];
+         rr.noalias() = u * Lambda[s];
+         for (SparseMatrix::InnerIterator it(Y, r); it; ++it)
+         {
+            const auto &v = row(s, other, it.col());
+            MM.noalias() += alpha * v.transpose() * v;
+            rr.noalias() += alpha * it.value() * v;
+         }
+
+         NormalPrior::sample_conditional(rr, MM);
+         u = rr;
+      }
+   }
+
+   return ret;
+}
+
+void SampleEnsemble::predict_entries(const FoldedRows &rows, int first_row, const std::vector<PVec<>> &coords,
+                                     const std::vector<int> &order, int begin, int end, BatchPrediction &ret) const
+{
+   const int S = m_nsamples;
+   const int K = nlatent();
+   const int mode = rows.mode;
+
+   #pragma omp parallel
+   {
+      Vector P(K);
+
+      #pragma omp for schedule(static)
+      for (int i = begin; i < end; ++i)
+      {
+         const int e = order[i];
+         const auto &pos = coords[e];
+         const int r = pos.at(mode) - first_row;
+
+         // running mean and sum of squared deviations (Welford)
+         double mean = 0.0, m2 = 0.0, p = 0.0;
+         for (int s = 0; s < S; ++s)
+         {
+            P = rows.latents.row(r).segment((Eigen::Index)s * K, K);
+            for (int m = 0; m < nmodes(); ++m)
+               if (m != mode)
+                  P.array() *= row(s, m, pos.at(m)).array();
+
+            p = P.sum();
+            const double delta = p - mean;
+            mean += delta / (s + 1);
+            m2 += delta * (p - mean);
+         }
+
+         ret.mean(e) = mean;
+         ret.var(e) = S > 1 ? m2 / (S - 1) : 0.0;
+         ret.last(e) = p;
+      }
+   }
+}
+
+BatchPrediction SampleEnsemble::predict_batch(const FoldedRows &rows, const std::vector<PVec<>> &coords) const
+{
+   COUNTER("predict batch");
+   THROWERROR_ASSERT_MSG(!empty(), "No samples to predict from");
+
+   const int E = coords.size();
+   BatchPrediction ret = makeBatch(E, 0);
+
+   std::vector<int> order(E);
+   std::iota(order.begin(), order.end(), 0);
+   predict_entries(rows, 0, coords, order, 0, E, ret);
+
+   return ret;
+}
+
+BatchPrediction SampleEnsemble::predict_batch(int mode, int num_rows, const std::vector<PVec<>> &coords, int chunk_rows, const RowSource &rows) const
+{
+   COUNTER("predict batch");
+   THROWERROR_ASSERT_MSG(!empty(), "No samples to predict from");
+   THROWERROR_ASSERT(chunk_rows > 0);
+
+   const int E = coords.size();
+   BatchPrediction ret = makeBatch(E, 0);
+
+   // entries by row, each chunk of rows is only computed when it is needed
+   std::vector<int> order(E);
+   std::iota(order.begin(), order.end(), 0);
+   std::stable_sort(order.begin(), order.end(), [&coords, mode](int a, int b) { return coords[a].at(mode) < coords[b].at(mode); });
+
+   int begin = 0;
+   for (int r0 = 0; r0 < num_rows && begin < E; r0 += chunk_rows)
+   {
+      const int n = std::min(chunk_rows, num_rows - r0);
+      int end = begin;
+      while (end < E && coords[order[end]].at(mode) < r0 + n)
+         ++end;
+
+      if (end > begin)
+         predict_entries(rows(r0, n), r0, coords, order, begin, end, ret);
+      begin = end;
+   }
+
+   THROWERROR_ASSERT_MSG(begin == E, "Entries outside of the " + std::to_string(num_rows) + " rows");
+
+   return ret;
+}
+
+void SampleEnsemble::otherModes(int s, int mode, Matrix &V) const
+{
+   const int K = nlatent();
+   V.setOnes(1, K);
+
+   for (int m = 0; m < nmodes(); ++m)
+   {
+      if (m == mode)
+         continue;
+
+      const auto Um = U(s, m);
+      Matrix next(V.rows() * Um.rows(), K);
+      for (int p = 0; p < V.rows(); ++p)
+         for (int i = 0; i < Um.rows(); ++i)
+            next.row(p * Um.rows() + i) = V.row(p).cwiseProduct(Um.row(i));
+      V.swap(next);
+   }
+}
+
+// rows of the new rows per task in predict_rows
+static const int PREDICT_ROWS_BLOCK = 32;
+
+void SampleEnsemble::predict_rows(const FoldedRows &rows, Matrix &mean, Matrix &var) const
+{
+   COUNTER("predict rows");
+   THROWERROR_ASSERT_MSG(!empty(), "No samples to predict from");
+
+   const int S = m_nsamples;
+   const int K = nlatent();
+   const int mode = rows.mode;
+   const int other = (mode + 1) % 2;
+   const int R = rows.latents.rows();
+
+   std::size_t cols = 1;
+   for (int m = 0; m < nmodes(); ++m)
+      if (m != mode)
+         cols *= m_dims.at(m);
+
+   mean.setZero(R, cols);
+   var.setZero(R, cols); // sum of squared deviations, until the end
+   Matrix V;
+
+   #pragma omp parallel
+   {
+      Matrix P, delta;
+
+      for (int s = 0; s < S; ++s)
+      {
+         #pragma omp single
+         if (nmodes() > 2)
+            otherModes(s, mode, V);
+
+         #pragma omp for schedule(dynamic, 1)
+         for (int r0 = 0; r0 < R; r0 += PREDICT_ROWS_BLOCK)
+         {
+            const int n = std::min(PREDICT_ROWS_BLOCK, R - r0);
+            const auto W = rows.latents.block(r0, (Eigen::Index)s * K, n, K);
+            if (nmodes() == 2)
+               P.noalias() = W * U(s, other).transpose();
+            else
+               P.noalias() = W * V.transpose();
+
+            // Welford, for the whole block at once
+            auto M = mean.middleRows(r0, n);
+            delta = P - M;
+            M += delta / (s + 1);
+            var.middleRows(r0, n).array() += delta.array() * (P - M).array();
+         }
+      }
+   }
+
+   if (S > 1)
+      var /= (S - 1);
+   else
+      var.setZero();
+}
+
+void SampleEnsemble::predict_rows(int num_rows, int chunk_rows, const RowSource &rows, const RowsOutput &out) const
+{
+   THROWERROR_ASSERT(chunk_rows > 0);
+
+   Matrix mean, var;
+   for (int r0 = 0; r0 < num_rows; r0 += chunk_rows)
+   {
+      predict_rows(rows(r0, std::min(chunk_rows, num_rows - r0)), mean, var);
+      out(r0, mean, var);
+   }
+}
+
+Recommendations SampleEnsemble::topN(int num_rows, int N, int chunk_rows, const RowSource &rows) const
+{
+   THROWERROR_ASSERT(chunk_rows > 0);
+
+   Recommendations ret;
+   ret.reserve(num_rows);
+   for (int r0 = 0; r0 < num_rows; r0 += chunk_rows)
+   {
+      const FoldedRows chunk = rows(r0, std::min(chunk_rows, num_rows - r0));
+      for (auto &r : topN(chunk.mode, chunk.latents, N))
+         ret.push_back(std::move(r));
+   }
+
+   return ret;
+}
+
+// rows of the query, and columns of the other mode, scored per GEMM
+static const int TOPN_ROW_BLOCK = 64;
+static const int TOPN_COL_BLOCK = 1024;
+
+const SampleEnsemble::Stacked &SampleEnsemble::stacked(int mode) const
+{
+   if (m_stacked.empty())
+      m_stacked.resize(nmodes());
+
+   Stacked &ret = m_stacked.at(mode);
+   if (ret.items.size())
+      return ret;
+
+   COUNTER("stack samples");
+   const int K = nlatent();
+   const int N = m_dims.at(mode);
+
+   std::vector<double> norms(N);
+   for (int n = 0; n < N; ++n)
+   {
+      double sq = 0.0;
+      for (int s = 0; s < m_nsamples; ++s)
+         sq += row(s, mode, n).squaredNorm();
+      norms[n] = std::sqrt(sq);
+   }
+
+   ret.items.resize(N);
+   std::iota(ret.items.begin(), ret.items.end(), 0);
+   std::stable_sort(ret.items.begin(), ret.items.end(), [&norms](int a, int b) { return norms[a] > norms[b]; });
+
+   ret.latents.resize(N, (Eigen::Index)m_nsamples * K);
+   ret.norms.resize(N);
+   #pragma omp parallel for schedule(static)
+   for (int k = 0; k < N; ++k)
+   {
+      const int n = ret.items[k];
+      for (int s = 0; s < m_nsamples; ++s)
+         ret.latents.block(k, (Eigen::Index)s * K, 1, K) = row(s, mode, n);
+      ret.norms[k] = norms[n];
+   }
+
+   return ret;
+}
+
+Recommendations SampleEnsemble::topN(int mode, const std::vector<int> &rows, int N) const
+{
+   const int K = nlatent();
+   Matrix W(rows.size(), (Eigen::Index)m_nsamples * K);
+   for (int r = 0; r < (int)rows.size(); ++r)
+      for (int s = 0; s < m_nsamples; ++s)
+         W.block(r, (Eigen::Index)s * K, 1, K) = row(s, mode, rows[r]);
+
+   return topN(mode, W, N);
+}
+
+Recommendations SampleEnsemble::topN(int mode, const Matrix &W, int N) const
+{
+   COUNTER("topN");
+   THROWERROR_ASSERT_MSG(!empty(), "No samples to predict from");
+   THROWERROR_ASSERT_MSG(nmodes() == 2, "Only implemented for modes == 2");
+   THROWERROR_ASSERT_MSG(N > 0, "N should be positive, got " + std::to_string(N));
+
+   typedef std::pair<float_type, int> Scored; // (mean score, position in V.items)
+   const auto worse = [](const Scored &a, const Scored &b) { return a.first > b.first; };
+
+   const int S = m_nsamples;
+   const int K = nlatent();
+   const Stacked &V = stacked((mode + 1) % 2);
+   const int M = V.items.size();
+   const int R = W.rows();
+   N = std::min(N, M);
+
+   // the mean over the samples of u_s . v_s is W.row(r) . V.row(j) / S,
+   // bounded by |W.row(r)| |V.row(j)| / S (Cauchy-Schwarz)
+   std::vector<double> wnorm(R);
+   for (int r = 0; r < R; ++r)
+      wnorm[r] = W.row(r).norm() / S;
+
+   Recommendations ret(R);
+   if (N == 0) // nothing to recommend from
+      return ret;
+
+   #pragma omp parallel
+   {
+      Matrix scores;
+      std::vector<std::vector<Scored>> heaps;
+
+      #pragma omp for schedule(dynamic, 1)
+      for (int r0 = 0; r0 < R; r0 += TOPN_ROW_BLOCK)
+      {
+         const int nr = std::min(TOPN_ROW_BLOCK, R - r0);
+         heaps.assign(nr, std::vector<Scored>());
+
+         for (int c0 = 0; c0 < M; c0 += TOPN_COL_BLOCK)
+         {
+            // all rows are done when no remaining column can beat their worst
+            bool done = true;
+            for (int r = 0; r < nr && done; ++r)
+               done = (int)heaps[r].size() == N && wnorm[r0 + r] * V.norms[c0] <= heaps[r].front().first;
+            if (done)
+               break;
+
+            const int nc = std::min(TOPN_COL_BLOCK, M - c0);
+            scores.noalias() = W.middleRows(r0, nr) * V.latents.middleRows(c0, nc).transpose();
+            scores /= S;
+
+            for (int r = 0; r < nr; ++r)
+            {
+               auto &heap = heaps[r];
+               for (int c = 0; c < nc; ++c)
+               {
+                  const Scored x(scores(r, c), c0 + c);
+                  if ((int)heap.size() < N)
+                  {
+                     heap.push_back(x);
+                     std::push_heap(heap.begin(), heap.end(), worse);
+                  }
+                  else if (worse(x, heap.front()))
+                  {
+                     std::pop_heap(heap.begin(), heap.end(), worse);
+                     heap.back() = x;
+                     std::push_heap(heap.begin(), heap.end(), worse);
+                  }
+               }
+            }
+         }
+
+         // mean and variance of the winners, one sample at a time
+         for (int r = 0; r < nr; ++r)
+         {
+            auto &heap = heaps[r];
+            std::sort_heap(heap.begin(), heap.end(), worse);
+
+            auto &out = ret[r0 + r];
+            for (const auto &x : heap)
+            {
+               // Welford's update, as ResultItem::update
+               double mean = 0.0, m2 = 0.0;
+               for (int s = 0; s < S; ++s)
+               {
+                  const double p = W.row(r0 + r).segment((Eigen::Index)s * K, K).dot(V.latents.row(x.second).segment((Eigen::Index)s * K, K));
+                  const double delta = p - mean;
+                  mean += delta / (s + 1);
+                  m2 += delta * (p - mean);
+               }
+               const double var = S > 1 ? m2 / (S - 1) : 0.0;
+               out.push_back(Recommendation{V.items[x.second], mean, var});
+            }
+         }
+      }
+   }
+
+   return ret;
+}
+
+} // end namespace smurff
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <SmurffCpp/Types.h>
+#include <SmurffCpp/Utils/PVec.hpp>
+#include <SmurffCpp/Utils/Error.h>
+
+namespace smurff {
+
+class SaveState;
+class ModelPack;
+struct ResultItem;
+
+// statistics over all samples of a batch of predictions, per entry
+struct BatchPrediction
+{
+   Vector mean;
+   Vector var;                    // sample variance (divided by nsamples - 1)
+   Vector last;                   // prediction of the last sample
+   std::vector<Vector> quantiles; // one Vector per requested quantile
+};
+
+// an item of the other mode, recommended for a row
+struct Recommendation
+{
+   int item;
+   double mean; // posterior mean prediction
+   double var;  // sample variance (divided by nsamples - 1)
+};
+
+typedef std::vector<std::vector<Recommendation>> Recommendations;
+
+// new rows of a mode, folded in or predicted from side info
+struct FoldedRows
+{
+   int mode;
+   Matrix latents; // row r = [u_0 | u_1 | ... | u_S-1], its latent vector in every sample
+};
+
+// The saved samples of a model, loaded once into memory.
+//
+// The latent matrices of mode m are stacked in one contiguous
+// (nsamples * N_m) x K matrix: sample s occupies rows [s * N_m, (s + 1) * N_m).
+class SampleEnsemble
+{
+public:
+   // load steps[i] for every i in select, all steps if select is empty
+   // with rows[m] not empty, mode m has only those rows: its row i is row rows[m][i]
+   void load(const std::vector<SaveState> &steps, const std::vector<int> &select = std::vector<int>(),
+             const std::vector<std::vector<std::size_t>> &rows = std::vector<std::vector<std::size_t>>());
+
+   // all samples of pack, the latent matrices are used where they are mapped
+   void load(std::shared_ptr<const ModelPack> pack);
+
+   bool empty() const { return m_nsamples == 0; }
+   int nsamples() const { return m_nsamples; }
+   int nmodes() const { return m_dims.size(); }
+   int nlatent() const { return m_num_latent; }
+   const PVec<> &getDims() const { return m_dims; }
+
+   // sample number of the step sample s was loaded from
+   int getIsample(int s) const { return m_isample.at(s); }
+
+   // U matrix of mode m in sample s
+   Eigen::Map<const Matrix> U(int s, int m) const
+   {
+      return Eigen::Map<const Matrix>(data(m) + (Eigen::Index)s * m_dims.at(m) * m_num_latent, m_dims.at(m), m_num_latent);
+   }
+
+   // latent vector of row n of mode m in sample s
+   Eigen::Map<const Vector> row(int s, int m, int n) const
+   {
+      return Eigen::Map<const Vector>(data(m) + ((Eigen::Index)s * m_dims.at(m) + n) * m_num_latent, m_num_latent);
+   }
+
+   const Matrix &getLinkMatrix(int s, int m) const { return m_link_matrices.at(s).at(m); }
+   const Vector &getMu(int s, int m) const { return m_mus.at(s).at(m); }
+
+   // prediction of sample s at pos
+   double predict(int s, const PVec<> &pos) const;
+
+   // update res with the prediction of every sample
+   void predict(ResultItem &res) const;
+
+   // all samples at once, for every entry in coords
+   BatchPrediction predict_batch(const std::vector<PVec<>> &coords, const std::vector<double> &quantiles = std::vector<double>()) const;
+
+   // all samples at once, for the dense block rows x cols of a 2-mode model
+   // entries are in row-major order, one GEMM per sample
+   BatchPrediction predict_batch(const std::vector<int> &rows, const std::vector<int> &cols, const std::vector<double> &quantiles = std::vector<double>()) const;
+
+   // for every row of mode in rows: the N items of the other mode with the
+   // highest posterior mean prediction, best first, 2-mode only
+   Recommendations topN(int mode, const std::vector<int> &rows, int N) const;
+
+   // same, for the latent vectors predicted from the rows of feature matrix f,
+   // chunk_rows rows at a time
+   template <typename FeatMatrix>
+   Recommendations topN(int mode, const FeatMatrix &f, int N, int chunk_rows = DEFAULT_CHUNK_ROWS) const;
+
+   // new rows of mode (2-mode only) with observations Y (rows x dim of the other
+   // mode) and noise precision alpha: per sample, one draw of each latent vector
+   // from its conditional given the other mode and the prior of that sample
+   FoldedRows foldIn(int mode, const SparseMatrix &Y, double alpha) const;
+
+   // same, the prior mean of row r is f.row(r) * beta + mu (Macau modes)
+   template <typename FeatMatrix>
+   FoldedRows foldIn(int mode, const SparseMatrix &Y, const FeatMatrix &f, double alpha) const;
+
+   // predictions for the block of folded-in rows x cols of the other mode,
+   // in row-major order
+   BatchPrediction predict_batch(const FoldedRows &rows, const std::vector<int> &cols, const std::vector<double> &quantiles = std::vector<double>()) const;
+
+   // the N best items of the other mode for each folded-in row
+   Recommendations topN(const FoldedRows &rows, int N) const { return topN(rows.mode, rows.latents, N); }
+
+   // latent vectors of the rows of feature matrix f in every sample
+   template <typename FeatMatrix>
+   FoldedRows latents(int mode, const FeatMatrix &f) const;
+
+   // rows of feature matrices processed at once by the streaming predictions
+   static const int DEFAULT_CHUNK_ROWS = 1024;
+
+   // entries with a new row: coords[e].at(rows.mode) is a row of rows, the
+   // other indices are rows of the other modes, any number of modes
+   BatchPrediction predict_batch(const FoldedRows &rows, const std::vector<PVec<>> &coords) const;
+
+   // same, coords[e].at(mode) is a row of feature matrix f, chunk_rows at a time
+   template <typename FeatMatrix>
+   BatchPrediction predict_batch(int mode, const FeatMatrix &f, const std::vector<PVec<>> &coords, int chunk_rows = DEFAULT_CHUNK_ROWS) const;
+
+   // mean and sample variance of all entries of the new rows, one row per
+   // new row, one column per combination of the indices of the other modes
+   // (in mode order, the last mode varying fastest), any number of modes
+   void predict_rows(const FoldedRows &rows, Matrix &mean, Matrix &var) const;
+
+   // out(first_row, mean, var) for every chunk of chunk_rows rows of f
+   typedef std::function<void(int first_row, const Matrix &mean, const Matrix &var)> RowsOutput;
+   template <typename FeatMatrix>
+   void predict_rows(int mode, const FeatMatrix &f, const RowsOutput &out, int chunk_rows = DEFAULT_CHUNK_ROWS) const;
+
+   // sample s: for each row in feature matrix f, predict the full row of the other mode
+   template <typename FeatMatrix>
+   Matrix predict(int s, int mode, const FeatMatrix &f) const;
+
+private:
+   // the stacked latent matrices of mode m, in m_latents or in m_pack
+   const float_type *data(int m) const { return m_pack ? m_pack_latents.at(m) : m_latents.at(m).data(); }
+
+   // W.row(r) = [u_0 | u_1 | ... | u_S-1], the latent vectors of row r in all samples
+   Recommendations topN(int mode, const Matrix &W, int N) const;
+
+   // streaming: rows(first_row, num_rows) = the new rows [first_row, first_row + num_rows)
+   typedef std::function<FoldedRows(int first_row, int num_rows)> RowSource;
+   Recommendations topN(int num_rows, int N, int chunk_rows, const RowSource &rows) const;
+   BatchPrediction predict_batch(int mode, int num_rows, const std::vector<PVec<>> &coords, int chunk_rows, const RowSource &rows) const;
+   void predict_rows(int num_rows, int chunk_rows, const RowSource &rows, const RowsOutput &out) const;
+
+   // entries order[begin, end) of coords, their rows are rows of rows offset by first_row
+   void predict_entries(const FoldedRows &rows, int first_row, const std::vector<PVec<>> &coords,
+                        const std::vector<int> &order, int begin, int end, BatchPrediction &ret) const;
+
+   // rows x K matrix of mode m in sample s, or for the other modes of
+   // a new row in mode: their Khatri-Rao product, in the column order of predict_rows
+   void otherModes(int s, int mode, Matrix &V) const;
+
+   // latent vectors of all samples side by side, rows by decreasing norm
+   struct Stacked
+   {
+      Matrix latents;
+      std::vector<int> items;
+      std::vector<double> norms;
+   };
+   const Stacked &stacked(int mode) const;
+
+   // M = prior means of the new rows, in the layout of FoldedRows::latents
+   FoldedRows foldIn(int mode, const SparseMatrix &Y, Matrix M, double alpha) const;
+
+   // prior precision of mode in every sample, see NormalPrior::posterior_mean_Lambda
+   const std::vector<Matrix> &lambdas(int mode) const;
+
+   // P(e, s) = prediction of sample s for entry e, summarized per entry
+   // block(s, out) sets out to the rows x cols predictions of sample s
+   template <typename F>
+   BatchPrediction predict_block(int E, const std::vector<double> &quantiles, F block) const;
+
+   int m_nsamples = 0;
+   int m_num_latent = 0;
+   PVec<> m_dims = PVec<>(0);
+   std::vector<int> m_isample;
+
+   std::vector<Matrix> m_latents;                    // per mode, unless loaded from a pack
+   std::shared_ptr<const ModelPack> m_pack;          // keeps the mapping alive
+   std::vector<const float_type *> m_pack_latents;   // per mode, in the mapped pack
+   std::vector<std::vector<Matrix>> m_link_matrices; // per sample, per mode
+   std::vector<std::vector<Vector>> m_mus;           // per sample, per mode
+
+   mutable std::vector<Stacked> m_stacked;           // per mode, built by the first topN()
+   mutable std::vector<std::vector<Matrix>> m_lambdas; // per mode, per sample, built by the first foldIn()
+};
+
+template <typename FeatMatrix>
+FoldedRows SampleEnsemble::latents(int mode, const FeatMatrix &f) const
+{
+   FoldedRows ret;
+   ret.mode = mode;
+
+   const int K = nlatent();
+   ret.latents.resize(f.rows(), (Eigen::Index)m_nsamples * K);
+   for (int s = 0; s < m_nsamples; ++s)
+   {
+      const auto &beta = getLinkMatrix(s, mode);
+      THROWERROR_ASSERT_MSG(beta.nonZeros(), "No link matrix available in mode " + std::to_string(mode));
+
+      auto u = ret.latents.middleCols((Eigen::Index)s * K, K);
+      u = f * beta;
+      u.rowwise() += getMu(s, mode);
+   }
+
+   return ret;
+}
+
+template <typename FeatMatrix>
+Recommendations SampleEnsemble::topN(int mode, const FeatMatrix &f, int N, int chunk_rows) const
+{
+   return topN(f.rows(), N, chunk_rows, [&](int first, int n) { return latents(mode, f.middleRows(first, n)); });
+}
+
+template <typename FeatMatrix>
+BatchPrediction SampleEnsemble::predict_batch(int mode, const FeatMatrix &f, const std::vector<PVec<>> &coords, int chunk_rows) const
+{
+   return predict_batch(mode, f.rows(), coords, chunk_rows, [&](int first, int n) { return latents(mode, f.middleRows(first, n)); });
+}
+
+template <typename FeatMatrix>
+void SampleEnsemble::predict_rows(int mode, const FeatMatrix &f, const RowsOutput &out, int chunk_rows) const
+{
+   predict_rows(f.rows(), chunk_rows, [&](int first, int n) { return latents(mode, f.middleRows(first, n)); }, out);
+}
+
+template <typename FeatMatrix>
+FoldedRows SampleEnsemble::foldIn(int mode, const SparseMatrix &Y, const FeatMatrix &f, double alpha) const
+{
+   THROWERROR_ASSERT_MSG(f.rows() == Y.rows(), "Need one row of features per new row");
+   return foldIn(mode, Y, latents(mode, f).latents, alpha);
+}
+
+template <typename FeatMatrix>
+Matrix SampleEnsemble::predict(int s, int mode, const FeatMatrix &f) const
+{
+   THROWERROR_ASSERT_MSG(nmodes() == 2, "Only implemented for modes == 2");
+
+   const auto &beta = getLinkMatrix(s, mode);
+   THROWERROR_ASSERT_MSG(beta.nonZeros(), "No link matrix available in mode " + std::to_string(mode));
+
+   Matrix latent = f * beta;
+   latent.rowwise() += getMu(s, mode);
+
+   return latent * U(s, (mode + 1) % 2).transpose();
+}
+
+} // end namespace smurff
@@ -0,0 +1,255 @@
+// GCC 12 reports 'result' as maybe uninitialized in Eigen's triangular and
+// selfadjoint matrix-vector products, as instantiated by the tridiagonalization
+// in SelfAdjointEigenSolver. Eigen writes that buffer before reading it. The
+// warning is raised at Eigen's own lines, so only the headers are covered here.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include "ServingModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/Eigenvalues>
+
+#include <highfive/H5File.hpp>
+
+#include <SmurffCpp/Utils/HDF5Group.h>
+#include <SmurffCpp/Utils/SaveState.h>
+#include <SmurffCpp/Utils/counters.h>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#define SERVING_TAG "serving"
+#define OPTIONS_SEC_TAG "options"
+#define LATENTS_SEC_TAG "latents"
+#define LINK_MATRICES_SEC_TAG "link_matrices"
+
+#define NUM_MODES_TAG "num_modes"
+#define NUM_LATENT_TAG "num_latent"
+#define NUM_SAMPLES_TAG "num_samples"
+#define VAR_RANK_TAG "var_rank"
+#define BITS_TAG "bits"
+
+#define MEAN_PREFIX "mean_"
+#define VAR_PREFIX "var_"
+#define LINK_MATRIX_PREFIX "link_matrix_"
+#define MU_PREFIX "mu_"
+#define SCALE_SUFFIX "_scale"
+
+namespace h5 = HighFive;
+
+namespace smurff {
+
+// 8 bit: M = diag(scale) * Q, with the integers Q in [-127, 127]
+static void writeQuantized(HDF5Group &g, const std::string &section, const std::string &tag, const Matrix &M, int bits)
+{
+   if (bits != 8)
+   {
+      g.writeQuantized(section, tag, M, bits);
+      return;
+   }
+
+   Vector scale = Vector::Ones(M.rows());
+   Matrix Q(M.rows(), M.cols());
+   for (int i = 0; i < M.rows(); ++i)
+   {
+      const double max = M.cols() ? M.row(i).cwiseAbs().maxCoeff() : 0.0;
+      if (max > 0)
+         scale(i) = max / 127;
+      Q.row(i) = (M.row(i) / scale(i)).array().round();
+   }
+
+   g.writeQuantized(section, tag, Q, 8);
+   g.write(section, tag + SCALE_SUFFIX, scale);
+}
+
+static void readQuantized(const HDF5Group &g, const std::string &section, const std::string &tag, Matrix &M)
+{
+   g.read(section, tag, M);
+   if (g.hasDataSet(section, tag + SCALE_SUFFIX))
+   {
+      Vector scale;
+      g.read(section, tag + SCALE_SUFFIX, scale);
+      M.array().colwise() *= scale.transpose().array();
+   }
+}
+
+ServingModel::ServingModel(const std::string &path)
+{
+   COUNTER("load serving model");
+   h5::File file(path, h5::File::ReadOnly);
+   HDF5Group g(file.getGroup(SERVING_TAG));
+
+   const int nmodes = g.get(OPTIONS_SEC_TAG, NUM_MODES_TAG, 0);
+   m_num_latent = g.get(OPTIONS_SEC_TAG, NUM_LATENT_TAG, 0);
+   m_nsamples = g.get(OPTIONS_SEC_TAG, NUM_SAMPLES_TAG, 0);
+   m_var_rank = g.get(OPTIONS_SEC_TAG, VAR_RANK_TAG, 0);
+
+   m_dims = PVec<>(nmodes);
+   m_means.resize(nmodes);
+   m_vars.resize(nmodes);
+   m_link_matrices.resize(nmodes);
+   m_mus.resize(nmodes);
+   for (int m = 0; m < nmodes; ++m)
+   {
+      readQuantized(g, LATENTS_SEC_TAG, MEAN_PREFIX + std::to_string(m), m_means[m]);
+      m_dims[m] = m_means[m].rows();
+      if (m_var_rank > 0)
+         readQuantized(g, LATENTS_SEC_TAG, VAR_PREFIX + std::to_string(m), m_vars[m]);
+
+      g.read(LINK_MATRICES_SEC_TAG, LINK_MATRIX_PREFIX + std::to_string(m), m_link_matrices[m]);
+      g.read(LINK_MATRICES_SEC_TAG, MU_PREFIX + std::to_string(m), m_mus[m]);
+   }
+}
+
+void ServingModel::build(const std::vector<SaveState> &steps, int var_rank)
+{
+   COUNTER("build serving model");
+   THROWERROR_ASSERT_MSG(!steps.empty(), "No samples to build a serving model from");
+
+   // the aggregates over all sampling iterations are saved with the last sample
+   const auto &last = *std::max_element(steps.begin(), steps.end(),
+      [](const SaveState &a, const SaveState &b) { return a.getIsample() < b.getIsample(); });
+
+   const int nmodes = last.getNModes();
+   m_nsamples = steps.size();
+   m_dims = PVec<>(nmodes);
+   m_means.resize(nmodes);
+   m_vars.assign(nmodes, Matrix());
+   m_link_matrices.resize(nmodes);
+   m_mus.resize(nmodes);
+
+   for (int m = 0; m < nmodes; ++m)
+   {
+      THROWERROR_ASSERT_MSG(last.hasPostMuLambda(m), "No posterior mean saved in " + last.getName());
+
+      Matrix prec;
+      last.readPostMuLambda(m, m_means[m], prec);
+      m_dims[m] = m_means[m].rows();
+      m_num_latent = m_means[m].cols();
+
+      const int K = m_num_latent;
+      const int N = m_dims[m];
+      m_var_rank = std::min(std::max(var_rank, 0), K);
+      const int r = m_var_rank;
+      if (r > 0)
+      {
+         // the largest eigenvalues of the covariance are the smallest of the precision
+         Matrix &L = m_vars[m];
+         L.resize(N, K * r);
+
+         #pragma omp parallel
+         {
+            Eigen::SelfAdjointEigenSolver<Matrix> eig(K);
+
+            #pragma omp for schedule(static)
+            for (int n = 0; n < N; ++n)
+            {
+               Eigen::Map<const Matrix> prec_n(prec.row(n).data(), K, K);
+               Eigen::Map<Matrix> L_n(L.row(n).data(), K, r);
+               L_n.setZero();
+
+               // e.g. a single sample, no covariance
+               if (!prec_n.allFinite())
+                  continue;
+
+               eig.compute(prec_n);
+               for (int j = 0; j < r; ++j)
+                  if (eig.eigenvalues()(j) > 0)
+                     L_n.col(j) = eig.eigenvectors().col(j) / std::sqrt(eig.eigenvalues()(j));
+            }
+         }
+      }
+
+      Matrix &beta = m_link_matrices[m];
+      Vector &mu = m_mus[m];
+      for (std::size_t s = 0; s < steps.size(); ++s)
+      {
+         Matrix beta_s;
+         Vector mu_s;
+         steps[s].readLinkMatrix(m, beta_s);
+         steps[s].readMu(m, mu_s);
+
+         if (s == 0)
+         {
+            beta = beta_s;
+            mu = mu_s;
+         }
+         else
+         {
+            beta += beta_s;
+            mu += mu_s;
+         }
+      }
+      beta /= m_nsamples;
+      mu /= m_nsamples;
+   }
+}
+
+void ServingModel::save(const std::string &path, int bits) const
+{
+   COUNTER("save serving model");
+   THROWERROR_ASSERT_MSG(bits == 0 || bits == 32 || bits == 16 || bits == 8,
+                         "bits should be 0 (full precision), 32, 16 or 8");
+
+   h5::File file(path, h5::File::Overwrite);
+   HDF5Group g(file.createGroup(SERVING_TAG));
+
+   g.put(OPTIONS_SEC_TAG, NUM_MODES_TAG, nmodes());
+   g.put(OPTIONS_SEC_TAG, NUM_LATENT_TAG, m_num_latent);
+   g.put(OPTIONS_SEC_TAG, NUM_SAMPLES_TAG, m_nsamples);
+   g.put(OPTIONS_SEC_TAG, VAR_RANK_TAG, m_var_rank);
+   g.put(OPTIONS_SEC_TAG, BITS_TAG, bits);
+
+   for (int m = 0; m < nmodes(); ++m)
+   {
+      writeQuantized(g, LATENTS_SEC_TAG, MEAN_PREFIX + std::to_string(m), m_means[m], bits);
+      if (m_var_rank > 0)
+         writeQuantized(g, LATENTS_SEC_TAG, VAR_PREFIX + std::to_string(m), m_vars[m], bits);
+
+      // small, kept at full precision
+      g.write(LINK_MATRICES_SEC_TAG, LINK_MATRIX_PREFIX + std::to_string(m), m_link_matrices[m]);
+      g.write(LINK_MATRICES_SEC_TAG, MU_PREFIX + std::to_string(m), m_mus[m]);
+   }
+
+   file.flush();
+}
+
+double ServingModel::predict(const PVec<> &pos) const
+{
+   if (nmodes() == 2)
+      return m_means[0].row(pos.at(0)).dot(m_means[1].row(pos.at(1)));
+
+   Vector P = m_means[0].row(pos.at(0));
+   for (int m = 1; m < nmodes(); ++m)
+      P.array() *= m_means[m].row(pos.at(m)).array();
+   return P.sum();
+}
+
+double ServingModel::predict(const PVec<> &pos, double &var) const
+{
+   var = 0.0;
+   if (m_var_rank == 0)
+      return predict(pos);
+
+   THROWERROR_ASSERT_MSG(nmodes() == 2, "Only implemented for modes == 2");
+
+   const int K = m_num_latent;
+   const int r = m_var_rank;
+   const auto &u = m_means[0].row(pos.at(0));
+   const auto &v = m_means[1].row(pos.at(1));
+   Eigen::Map<const Matrix> Lu(m_vars[0].row(pos.at(0)).data(), K, r);
+   Eigen::Map<const Matrix> Lv(m_vars[1].row(pos.at(1)).data(), K, r);
+
+   // var(u . v) = v' Su v + u' Sv u + tr(Su Sv), with S = L L'
+   var = (v * Lu).squaredNorm() + (u * Lv).squaredNorm() + (Lu.transpose() * Lv).squaredNorm();
+
+   return u.dot(v);
+}
+
+} // end namespace smurff
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <SmurffCpp/Types.h>
+#include <SmurffCpp/Utils/PVec.hpp>
+#include <SmurffCpp/Utils/Error.h>
+
+namespace smurff {
+
+class SaveState;
+
+// Mean-field approximation of a trained model, for low-latency serving.
+//
+// Instead of all saved samples it keeps, per mode, the posterior mean of U
+// (aggregated over all sampling iterations), optionally a rank-r factor L of
+// the posterior covariance of every row (Sigma ~ L L'), and the averaged link
+// matrix and mu. A prediction costs O(K), or O(K r^2) with its variance.
+class ServingModel
+{
+public:
+   ServingModel() {}
+
+   // load a model written by save()
+   ServingModel(const std::string &path);
+
+   // from the posterior mean and precision saved with the last of steps,
+   // keeping the top var_rank eigenvectors of each row covariance
+   void build(const std::vector<SaveState> &steps, int var_rank = 0);
+
+   // bits = 0 (full precision), 32 or 16 bit floats, or 8 bit integers
+   // with a scale per row
+   void save(const std::string &path, int bits = 0) const;
+
+   int nmodes() const { return m_dims.size(); }
+   int nlatent() const { return m_num_latent; }
+   int nsamples() const { return m_nsamples; }
+   int varRank() const { return m_var_rank; }
+   const PVec<> &getDims() const { return m_dims; }
+
+   const Matrix &mean(int mode) const { return m_means.at(mode); }
+
+   // posterior mean prediction at pos
+   double predict(const PVec<> &pos) const;
+
+   // same, var = its variance under the mean-field approximation, 2-mode only
+   double predict(const PVec<> &pos, double &var) const;
+
+   // for each row in feature matrix f, predict the full row of the other mode
+   template <typename FeatMatrix>
+   Matrix predict(int mode, const FeatMatrix &f) const;
+
+private:
+   int m_nsamples = 0;
+   int m_num_latent = 0;
+   int m_var_rank = 0;
+   PVec<> m_dims = PVec<>(0);
+
+   std::vector<Matrix> m_means;         // per mode, N x K
+   std::vector<Matrix> m_vars;          // per mode, N x (K * r), row n is L_n (K x r, row-major)
+   std::vector<Matrix> m_link_matrices; // per mode, averaged over the samples
+   std::vector<Vector> m_mus;           // per mode, averaged over the samples
+};
+
+template <typename FeatMatrix>
+Matrix ServingModel::predict(int mode, const FeatMatrix &f) const
+{
+   THROWERROR_ASSERT_MSG(nmodes() == 2, "Only implemented for modes == 2");
+
+   const auto &beta = m_link_matrices.at(mode);
+   THROWERROR_ASSERT_MSG(beta.nonZeros(), "No link matrix available in mode " + std::to_string(mode));
+
+   Matrix latent = f * beta;
+   latent.rowwise() += m_mus.at(mode);
+
+   return latent * m_means.at((mode + 1) % 2).transpose();
+}
+
+} // end namespace smurff
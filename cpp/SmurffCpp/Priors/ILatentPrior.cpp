@@ -14,6 +14,11 @@ void ILatentPrior::init()
    rrs.init(Vector::Zero(num_latent()));
    MMs.init(Matrix::Zero(num_latent(), num_latent()));
 
+   std::vector<int> nnz(num_item());
+   for (int n = 0; n < num_item(); n++)
+      nnz[n] = data().row_nnz(m_mode, n);
+   m_scheduler.init(nnz);
+
    //this is some new initialization
    init_Usum();
 }
@@ -105,25 +110,24 @@ void ILatentPrior::sample_latents()
    COUNTER("sample_latents");
    data().update_pnm(model(), m_mode);
 
-   #pragma omp parallel for schedule(guided)
-   for (int n = 0; n < U().rows(); n++)
-   #pragma omp task
+   data().setSplitNNZ(m_mode, m_scheduler.split_nnz());
+
+   m_scheduler.run([this](int n)
    {
       COUNTER("sample_latent");
       sample_latent(n);
       const auto &row = U().row(n);
       Urow.local().noalias() += row;
       UUrow.local().noalias() += row.transpose() * row;
-
-      if (m_session.inSamplingPhase())
-         model().updateAggr(m_mode, n);
-   }
+   });
 
    if (m_session.inSamplingPhase())
       model().updateAggr(m_mode);
 
-   Usum = Urow.combine_and_reset();
-   UUsum = UUrow.combine_and_reset();
+   model().updateActive(m_mode);
+
+   Urow.combine_and_reset(Usum);
+   UUrow.combine_and_reset(UUsum);
 }
 
 bool ILatentPrior::save(SaveState &sf) const
@@ -10,6 +10,7 @@
 #include <SmurffCpp/DataMatrices/Data.h>
 #include <SmurffCpp/Utils/Distribution.h>
 #include <SmurffCpp/Utils/ThreadVector.hpp>
+#include <SmurffCpp/Utils/RowScheduler.h>
 
 #include <SmurffCpp/Model.h>
 
@@ -85,6 +86,9 @@ private:
    // for effiency, we keep + update Urow and UUrow by every thread
    thread_vector<Vector> Urow;
    thread_vector<Matrix> UUrow;
+
+   // order and grouping of rows in sample_latents
+   RowScheduler m_scheduler;
    
 public:
    void setMode(std::uint32_t value)
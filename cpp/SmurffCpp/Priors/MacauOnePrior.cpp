@@ -1,5 +1,8 @@
 #include "MacauOnePrior.h"
 
+#include <SmurffCpp/Utils/counters.h>
+#include <SmurffCpp/Utils/omp_util.h>
+
 namespace smurff {
 
 MacauOnePrior::MacauOnePrior(TrainSession &trainSession, uint32_t mode)
@@ -45,39 +48,94 @@ void MacauOnePrior::addSideInfo(const std::shared_ptr<ISideInfo>& si, double bp,
    bp0 = bp;
    enable_beta_precision_sampling = ebps;
    F_colsq = Features->col_square_sum();
+   feature_groups = Features->feature_groups();
 }
 
 void MacauOnePrior::sample_beta(const Matrix &U)
 {
-   // updating beta() and beta_var
-   const int nfeat = num_feat();
+   // Z = U - mu - Uhat, kept up to date while beta() changes
    const int nitem = num_item();
-   const int blocksize = 4;
+   Matrix Z(nitem, num_latent());
+
+   #pragma omp parallel for schedule(static)
+   for (int i = 0; i < nitem; i++)
+   {
+      for (int d = 0; d < num_latent(); d++)
+      {
+         Z(i, d) = U(i, d) - mu()(d) - Uhat(i, d);
+      }
+   }
+
+   // too few features per group to keep all threads busy
+   // (e.g. dense side info, every feature in its own group):
+   // parallelize over latent dimensions instead
+   if (num_feat() < (int)feature_groups.size() * threads::get_max_threads())
+      sample_beta_latent_blocks(Z);
+   else
+      sample_beta_grouped(Z);
+}
 
-   Matrix Z;
+void MacauOnePrior::sample_beta_grouped(Matrix &Z)
+{
+   COUNTER("sample_beta_grouped");
+   const int nlatent = num_latent();
 
-   #pragma omp parallel for private(Z) schedule(static, 1)
-   for (int dstart = 0; dstart < num_latent(); dstart += blocksize)
+   #pragma omp parallel
    {
-      const int dcount = std::min(blocksize, num_latent() - dstart);
-      Z.resize(nitem, dcount);
+      // per-thread, reused for every feature
+      Vector zx(nlatent), delta_beta(nlatent), eps(nlatent);
 
-      for (int i = 0; i < nitem; i++)
+      for (const auto &group : feature_groups)
       {
-         for (int d = 0; d < dcount; d++)
+         // features in a group touch disjoint rows of Z
+         #pragma omp for schedule(dynamic, 16)
+         for (int g = 0; g < (int)group.size(); g++)
          {
-            int dx = d + dstart;
-            Z(i, d) = U(i, dx) - mu()(dx) - Uhat(i, dx);
+            const int f = group[g];
+            // zx = Z' * F[:, f]
+            Features->At_mul_Bt(zx, f, Z);
+            // normals come in pairs, draw them for all latent dimensions at once
+            eps = RandomVectorExpr(nlatent);
+
+            for (int d = 0; d < nlatent; d++)
+            {
+               double A_df = beta_precision(d) + Lambda(d, d) * F_colsq(f);
+               double B_df = Lambda(d, d) * (zx(d) + beta()(f, d) * F_colsq(f));
+               double A_inv = 1.0 / A_df;
+               double beta_new = B_df * A_inv + std::sqrt(A_inv) * eps(d);
+               delta_beta(d) = beta()(f, d) - beta_new;
+
+               beta()(f, d) = beta_new;
+            }
+            // Z += F[:, f] * delta_beta'
+            Features->add_Acol_mul_bt(Z, f, delta_beta);
          }
       }
+   }
+}
+
+void MacauOnePrior::sample_beta_latent_blocks(Matrix &Z)
+{
+   COUNTER("sample_beta_latent_blocks");
+   const int nfeat = num_feat();
+   const int nitem = num_item();
+   const int blocksize = 4;
+
+   Matrix Zblock;
+
+   #pragma omp parallel for private(Zblock) schedule(static, 1)
+   for (int dstart = 0; dstart < num_latent(); dstart += blocksize)
+   {
+      const int dcount = std::min(blocksize, num_latent() - dstart);
+      Zblock = Z.block(0, dstart, nitem, dcount);
+
+      Vector zx(dcount), delta_beta(dcount), eps(dcount);
 
       for (int f = 0; f < nfeat; f++)
       {
-         Vector zx(dcount), delta_beta(dcount);
          // zx = Z[dstart : dstart + dcount, :] * F[:, f]
-         Features->At_mul_Bt(zx, f, Z);
-         // TODO: check if sampling randvals for whole [nfeat x dcount] matrix works faster
-         auto randvals = Vector::NullaryExpr(dcount, RandNormalGenerator());
+         Features->At_mul_Bt(zx, f, Zblock);
+         eps = RandomVectorExpr(dcount);
 
          for (int d = 0; d < dcount; d++)
          {
@@ -85,13 +143,13 @@ void MacauOnePrior::sample_beta(const Matrix &U)
             double A_df = beta_precision(dx) + Lambda(dx, dx) * F_colsq(f);
             double B_df = Lambda(dx, dx) * (zx(d) + beta()(f, dx) * F_colsq(f));
             double A_inv = 1.0 / A_df;
-            double beta_new = B_df * A_inv + std::sqrt(A_inv) * randvals(d);
+            double beta_new = B_df * A_inv + std::sqrt(A_inv) * eps(d);
             delta_beta(d) = beta()(f, dx) - beta_new;
 
             beta()(f, dx) = beta_new;
          }
          // Z[dstart : dstart + dcount, :] += F[:, f] * delta_beta'
-         Features->add_Acol_mul_bt(Z, f, delta_beta);
+         Features->add_Acol_mul_bt(Zblock, f, delta_beta);
       }
    }
 }
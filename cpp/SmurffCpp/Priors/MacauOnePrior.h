@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <SmurffCpp/Types.h>
 
@@ -27,6 +28,7 @@ public:
    double beta_precision_b0; // Hyper-prior for beta_precision
 
    std::shared_ptr<ISideInfo> Features;  // side information
+   std::vector<std::vector<int>> feature_groups; // features in a group share no items
    Vector beta_precision;
    double bp0;
    bool enable_beta_precision_sampling;
@@ -54,6 +56,12 @@ public:
 
    void sample_beta(const Matrix &U);
 
+   // sample_beta in parallel over the features in each group
+   void sample_beta_grouped(Matrix &Z);
+
+   // sample_beta in parallel over blocks of latent dimensions
+   void sample_beta_latent_blocks(Matrix &Z);
+
    //used in update_prior
 
    void sample_mu_lambda(const Matrix &U);
@@ -28,6 +28,10 @@ void NormalOnePrior::init()
    mu0.setZero();
    b0 = 2;
    df = K;
+
+   XXws.init(Matrix::Zero(K, K));
+   yXws.init(Vector::Zero(K));
+   UXXws.init(Vector::Zero(K));
 }
 
 const Vector NormalOnePrior::fullMu(int n) const
@@ -44,8 +48,12 @@ void NormalOnePrior::sample_latent(int d)
 {
    const int K = num_latent();
 
-   Matrix XX = Matrix::Zero(K, K);
-   Vector yX = Vector::Zero(K);
+   auto &XX = XXws.local();
+   auto &yX = yXws.local();
+   auto &UXX = UXXws.local();
+
+   XX.setZero();
+   yX.setZero();
 
    data().getMuLambda(model(), m_mode, d, yX, XX);
 
@@ -53,15 +61,41 @@ void NormalOnePrior::sample_latent(int d)
    yX.noalias() += mu() * Lambda;
    XX.noalias() += Lambda;
 
-   for(int k=0;k<K;++k) sample_latent(d, k, XX, yX);
+   // UXX = Urow * XX, skipping zero latents
+   auto Urow = U().row(d);
+   UXX.setZero();
+   for (int k = 0; k < K; ++k)
+      if (Urow(k) != 0) UXX.noalias() += Urow(k) * XX.row(k);
+
+   for(int k=0;k<K;++k) sample_latent(d, k, XX, yX, UXX);
+}
+
+std::pair<float_type,float_type> NormalOnePrior::cond_mu_lambda(int d, int k, const Eigen::Ref<const Matrix> &XX, const Eigen::Ref<const Vector> &yX, const Eigen::Ref<const Vector> &UXX, float_type diag) const
+{
+    // the extra diagonal does not contribute to the mean: it only
+    // appears in Urow * XX.row(k) and Urow(k) * XX(k,k), which cancel
+    const float_type Udk = U()(d, k);
+    float_type lambda = XX(k,k) + diag;
+    float_type mu = (1/lambda) * (yX(k) - UXX(k) + Udk * XX(k,k));
+    return std::make_pair(mu, lambda);
+}
+
+void NormalOnePrior::set_latent(int d, int k, float_type value, const Eigen::Ref<const Matrix> &XX, Eigen::Ref<Vector> UXX)
+{
+    float_type &Udk = U()(d, k);
+    const float_type delta = value - Udk;
+    if (delta == 0) return;
+
+    // XX is symmetric: row k == column k
+    UXX.noalias() += delta * XX.row(k);
+    Udk = value;
 }
- 
-std::pair<float_type,float_type> NormalOnePrior::sample_latent(int d, int k, const Matrix& XX, const Vector& yX)
+
+std::pair<float_type,float_type> NormalOnePrior::sample_latent(int d, int k, const Eigen::Ref<const Matrix> &XX, const Eigen::Ref<const Vector> &yX, Eigen::Ref<Vector> UXX)
 {
-    auto Urow = U().row(d);
-    float_type lambda = XX(k,k);
-    float_type mu = (1/lambda) * (yX(k) - Urow * XX.row(k).transpose() + Urow(k) * XX(k,k));
-    Urow(k) = mu + rand_normal() / sqrt(lambda);
+    float_type mu, lambda;
+    std::tie(mu, lambda) = cond_mu_lambda(d, k, XX, yX, UXX);
+    set_latent(d, k, mu + rand_normal() / sqrt(lambda), XX, UXX);
     return std::make_pair(mu, lambda);
 }
 
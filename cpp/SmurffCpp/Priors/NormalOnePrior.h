@@ -5,6 +5,7 @@
 #include <SmurffCpp/Types.h>
 
 #include <SmurffCpp/Utils/Distribution.h>
+#include <SmurffCpp/Utils/ThreadVector.hpp>
 
 #include <SmurffCpp/Priors/ILatentPrior.h>
 
@@ -26,6 +27,10 @@ public:
   int b0;
   int df;
 
+  // per-thread workspaces for sample_latent(n)
+  thread_vector<Matrix> XXws;
+  thread_vector<Vector> yXws, UXXws;
+
 public:
    NormalOnePrior(TrainSession &trainSession, uint32_t mode, std::string name = "NormalOnePrior");
    virtual ~NormalOnePrior() {}
@@ -37,7 +42,18 @@ public:
    virtual const Vector fullMu(int n) const;
 
    void sample_latent(int n) override;
-   virtual std::pair<float_type,float_type> sample_latent(int d, int k, const Matrix& XX, const Vector& yX);
+
+   // sample U(d,k), with UXX == U.row(d) * XX kept up to date
+   virtual std::pair<float_type,float_type> sample_latent(int d, int k, const Eigen::Ref<const Matrix> &XX, const Eigen::Ref<const Vector> &yX, Eigen::Ref<Vector> UXX);
+
+protected:
+   // conditional mean and precision of U(d,k), with extra precision on the diagonal
+   std::pair<float_type,float_type> cond_mu_lambda(int d, int k, const Eigen::Ref<const Matrix> &XX, const Eigen::Ref<const Vector> &yX, const Eigen::Ref<const Vector> &UXX, float_type diag = 0) const;
+
+   // U(d,k) = value, updates UXX only when U(d,k) changes
+   void set_latent(int d, int k, float_type value, const Eigen::Ref<const Matrix> &XX, Eigen::Ref<Vector> UXX);
+
+public:
 
    void update_prior() override;
 
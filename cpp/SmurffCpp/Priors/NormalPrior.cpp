@@ -14,6 +14,15 @@ namespace smurff {
 
 //  base class NormalPrior
 
+// hyperparameters of the Normal-Wishart prior on (mu, Lambda)
+static void default_hyperparams(int K, Matrix &WI, Vector &mu0, int &b0, int &df)
+{
+   WI.setIdentity(K, K);
+   mu0.setZero(K);
+   b0 = 2;
+   df = K;
+}
+
 NormalPrior::NormalPrior(TrainSession &trainSession, uint32_t mode, std::string name)
    : ILatentPrior(trainSession, mode, name)
 {}
@@ -32,25 +41,68 @@ void NormalPrior::init()
    Lambda *= 10;
 
    // parameters of Inv-Whishart distribution
-   WI.resize(K, K);
-   WI.setIdentity();
-   mu0.resize(K);
-   mu0.setZero();
-   b0 = 2;
-   df = K;
+   default_hyperparams(K, WI, mu0, b0, df);
+
+   Rs.init(Matrix::Zero(K, K));
+   VVs.init(Matrix::Zero(K, K));
 
    const auto &config = getConfig();
-   if (config.hasPropagatedPosterior(getMode()))
+   m_propagated = config.hasPropagatedPosterior(getMode());
+   if (m_propagated)
    {
       m_name += " with posterior propagation";
+      init_propagated_posterior();
+   }
+}
+
+// The config stores mu as K x N and Lambda as K*K x N (one column per item).
+// Transpose both into contiguous rows and factorize every Lambda_n once,
+// instead of copying and refactorizing them for every row in every iteration.
+void NormalPrior::init_propagated_posterior()
+{
+   COUNTER("init_propagated_posterior");
+
+   const int K = num_latent();
+   const int N = num_item();
+   const auto &mu_pp = getConfig().getMuPropagatedPosterior(getMode()).getDenseMatrixData();
+   const auto &Lambda_pp = getConfig().getLambdaPropagatedPosterior(getMode()).getDenseMatrixData();
+
+   THROWERROR_ASSERT(mu_pp.rows() == K && mu_pp.cols() == N);
+   THROWERROR_ASSERT(Lambda_pp.rows() == K * K && Lambda_pp.cols() == N);
+
+   pp_mu = mu_pp.transpose();
+   pp_Lambda = Lambda_pp.transpose();
+   pp_R.resize(N, K * K);
+   pp_LambdaMu.resize(N, K);
+
+   int failed = 0;
+   #pragma omp parallel for schedule(guided) reduction(+:failed)
+   for (int n = 0; n < N; ++n)
+   {
+      Eigen::Map<const Matrix> Lambda_n(pp_Lambda.row(n).data(), K, K);
+      pp_LambdaMu.row(n).noalias() = pp_mu.row(n) * Lambda_n;
+
+      Eigen::LLT<Matrix> chol(Lambda_n);
+      if (chol.info() != Eigen::Success)
+      {
+         failed++;
+         continue;
+      }
+      Eigen::Map<Matrix>(pp_R.row(n).data(), K, K) = chol.matrixU();
+   }
+
+   if (failed)
+   {
+      THROWERROR("Cholesky Decomposition failed! Lambda of propagated posterior is not positive definite for "
+                 + std::to_string(failed) + " items");
    }
 }
 
 const Vector NormalPrior::fullMu(int n) const
 {
-   if (getConfig().hasPropagatedPosterior(getMode()))
+   if (m_propagated)
    {
-      return getConfig().getMuPropagatedPosterior(getMode()).getDenseMatrixData().row(n);
+      return pp_mu.row(n);
    }
    //else
    return mu();
@@ -58,27 +110,109 @@ const Vector NormalPrior::fullMu(int n) const
 
 const Matrix NormalPrior::getLambda(int n) const
 {
-   if (getConfig().hasPropagatedPosterior(getMode()))
+   if (m_propagated)
    {
-      const auto &Lambda_pp = getConfig().getLambdaPropagatedPosterior(getMode()).getDenseMatrixData();
-      return Eigen::Map<const Matrix>(Lambda_pp.row(n).data(), num_latent(), num_latent());
+      return Eigen::Map<const Matrix>(pp_Lambda.row(n).data(), num_latent(), num_latent());
    }
    //else
    return Lambda;
 }
+
+Eigen::Map<const Matrix> NormalPrior::prior_R(int n) const
+{
+   const int K = num_latent();
+   if (m_propagated)
+   {
+      return Eigen::Map<const Matrix>(pp_R.row(n).data(), K, K);
+   }
+   //else
+   return Eigen::Map<const Matrix>(Lambda_R.data(), K, K);
+}
+
+void NormalPrior::add_prior_mean(int n, Eigen::Ref<Vector> rr) const
+{
+   if (m_propagated)
+   {
+      rr.noalias() += pp_LambdaMu.row(n);
+      return;
+   }
+   //else
+   rr.noalias() += fullMu(n) * Lambda;
+}
 void NormalPrior::update_prior()
 {
    std::tie(mu(), Lambda) = CondNormalWishart(num_item(), getUUsum(), getUsum(), mu0, b0, WI, df);
 }
 
+// rows with fewer observations than num_latent / LOWCOUNT_RATIO use
+// rank-1 updates of the Cholesky factor of Lambda instead of a full Cholesky
+static const int LOWCOUNT_RATIO = 8;
+
+void NormalPrior::sample_latents()
+{
+   // with posterior propagation the factors were computed in init()
+   if (!m_propagated)
+   {
+      Eigen::LLT<Matrix> chol = Lambda.llt();
+      if(chol.info() != Eigen::Success)
+      {
+         THROWERROR("Cholesky Decomposition failed!");
+      }
+      Lambda_R = chol.matrixU();
+   }
+
+   ILatentPrior::sample_latents();
+}
+
+void NormalPrior::sample_latent_empty(int n)
+{
+   // x = mu + R^-1 * z
+   auto &rr = rrs.local();
+   rr = Vector::NullaryExpr(num_latent(), RandNormalGenerator());
+   prior_R(n).triangularView<Eigen::Upper>().solveInPlace(rr.transpose());
+   U().row(n).noalias() = fullMu(n) + rr;
+}
+
+void NormalPrior::sample_latent_lowcount(int n, int nnz)
+{
+   auto &rr = rrs.local();
+   auto &R = Rs.local();
+   auto &VV = VVs.local();
+
+   rr.setZero();
+   data().getMuRows(model(), m_mode, n, rr, VV);
+
+   add_prior_mean(n, rr);
+
+   // MM = Lambda + VV' * VV = R' * R
+   R = prior_R(n);
+   for (int i = 0; i < nnz; ++i)
+      matrix_utils::chol_rank1_update(R, VV.row(i));
+
+   R.transpose().triangularView<Eigen::Lower>().solveInPlace(rr.transpose());
+   rr.noalias() += Vector::NullaryExpr(num_latent(), RandNormalGenerator());
+   R.triangularView<Eigen::Upper>().solveInPlace(rr.transpose());
+
+   U().row(n).noalias() = rr;
+}
+
 //n is an index of column in U matrix
 void  NormalPrior::sample_latent(int n)
 {
-   const auto &mu_u = fullMu(n);
-   const auto &Lambda_u = getLambda(n);
+   const int nnz = data().row_nnz(m_mode, n);
+   if (nnz == 0)
+   {
+      sample_latent_empty(n);
+      return;
+   }
+   if (nnz > 0 && nnz * LOWCOUNT_RATIO < num_latent())
+   {
+      sample_latent_lowcount(n, nnz);
+      return;
+   }
 
-   Vector &rr = rrs.local();
-   Matrix &MM = MMs.local();
+   auto &rr = rrs.local();
+   auto &MM = MMs.local();
 
    rr.setZero();
    MM.setZero();
@@ -87,9 +221,19 @@ void  NormalPrior::sample_latent(int n)
    data().getMuLambda(model(), m_mode, n, rr, MM);
 
    // add hyperparams
-   rr.noalias() += mu_u * Lambda_u;
-   MM.noalias() += Lambda_u;
+   add_prior_mean(n, rr);
+   if (m_propagated)
+      MM += Eigen::Map<const Matrix>(pp_Lambda.row(n).data(), num_latent(), num_latent());
+   else
+      MM += Lambda;
+
+   sample_conditional(rr, MM);
 
+   U().row(n).noalias() = rr; // rr is equal to x
+}
+
+void NormalPrior::sample_conditional(Eigen::Ref<Vector> rr, const Eigen::Ref<const Matrix> &MM)
+{
    //Solve system of linear equations for x: MM * x = rr - not exactly correct  because we have random part
    //Sample from multivariate normal distribution with mean rr and precision matrix MM
 
@@ -103,10 +247,24 @@ void  NormalPrior::sample_latent(int n)
    }
 
    chol.matrixL().solveInPlace(rr.transpose()); // solve for y: y = L^-1 * b
-   rr.noalias() += Vector::NullaryExpr(num_latent(), RandNormalGenerator());
+   rr.noalias() += Vector::NullaryExpr(rr.size(), RandNormalGenerator());
    chol.matrixU().solveInPlace(rr.transpose()); // solve for x: x = U^-1 * y
-   
-   U().row(n).noalias() = rr; // rr is equal to x
+}
+
+Matrix NormalPrior::posterior_mean_Lambda(const Matrix &U)
+{
+   Matrix WI;
+   Vector mu0;
+   int b0, df;
+   default_hyperparams(U.cols(), WI, mu0, b0, df);
+
+   // as in CondNormalWishart, E[Wishart(T, nu)] = nu * T
+   const int N = U.rows();
+   const double kappa_c = b0 + N;
+   const Vector mu_c = (b0 * mu0 + U.colwise().sum()) / kappa_c;
+   const Matrix X = WI + U.transpose() * U + b0 * mu0.transpose() * mu0 - kappa_c * mu_c.transpose() * mu_c;
+
+   return (df + N) * X.inverse();
 }
 
 std::ostream &NormalPrior::status(std::ostream &os, std::string indent) const
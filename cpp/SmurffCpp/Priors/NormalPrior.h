@@ -2,7 +2,6 @@
 
 #include <memory>
 
-#include <SmurffCpp/Types.h>
 #include <SmurffCpp/Types.h>
 
 #include <SmurffCpp/Utils/Distribution.h>
@@ -28,6 +27,17 @@ public:
   int b0;
   int df;
 
+  // Lambda = R' * R, refreshed at the start of every sample_latents
+  // for the empty-row and low-count-row fast paths
+  Matrix Lambda_R;
+  thread_vector<Matrix> Rs, VVs;
+
+  // propagated posterior, preprocessed once in init()
+  // row n holds mu_n, Lambda_n (K x K, row-major), its upper Cholesky
+  // factor R_n and mu_n * Lambda_n
+  bool m_propagated = false;
+  Matrix pp_mu, pp_Lambda, pp_R, pp_LambdaMu;
+
 public:
   NormalPrior(TrainSession &trainSession, uint32_t mode, std::string name = "NormalPrior");
   virtual ~NormalPrior() {}
@@ -39,8 +49,32 @@ public:
   virtual const Vector fullMu(int n) const;
   const Matrix getLambda(int n) const;
   
+  void sample_latents() override;
   void sample_latent(int n) override;
 
+  // rr = a sample from N(MM^-1 * rr', MM^-1), the conditional of a latent
+  // vector with precision MM and rr = mean * MM, as set up in sample_latent
+  static void sample_conditional(Eigen::Ref<Vector> rr, const Eigen::Ref<const Matrix> &MM);
+
+  // mean of the Normal-Wishart posterior of Lambda given the rows of U,
+  // with the hyperparameters of init()
+  static Matrix posterior_mean_Lambda(const Matrix &U);
+
+private:
+  void init_propagated_posterior();
+
+  // R' * R = prior precision of row n
+  Eigen::Map<const Matrix> prior_R(int n) const;
+  // rr += fullMu(n) * prior precision of row n
+  void add_prior_mean(int n, Eigen::Ref<Vector> rr) const;
+
+  // no observations: sample from the prior
+  void sample_latent_empty(int n);
+  // few observations: rank-nnz update of Lambda_R instead of a Cholesky of MM
+  void sample_latent_lowcount(int n, int nnz);
+
+public:
+
   void update_prior() override;
   std::ostream &status(std::ostream &os, std::string indent) const override;
 };
@@ -10,6 +10,8 @@
 
 #include <SmurffCpp/SideInfo/DenseSideInfo.h>
 #include <SmurffCpp/SideInfo/SparseSideInfo.h>
+#include <SmurffCpp/SideInfo/BinarySparseSideInfo.h>
+#include <SmurffCpp/SideInfo/MixedSparseSideInfo.h>
 
 namespace smurff {
 
@@ -73,8 +75,10 @@ std::shared_ptr<ILatentPrior> PriorFactory::create_macau_prior(TrainSession &tra
    Factory &subFactory = dynamic_cast<Factory &>(*this);
 
    std::shared_ptr<ISideInfo> side_info;
-   if (config_item.isDense()) side_info = std::make_shared<DenseSideInfo>(config_item);
-   else                       side_info = std::make_shared<SparseSideInfo>(config_item);
+   if (config_item.isDense())                side_info = std::make_shared<DenseSideInfo>(config_item);
+   else if (config_item.isBinary())          side_info = std::make_shared<BinarySparseSideInfo>(config_item);
+   else if (config_item.getMixedPrecision()) side_info = std::make_shared<MixedSparseSideInfo>(config_item);
+   else                                      side_info = std::make_shared<SparseSideInfo>(config_item);
 
    return subFactory.create_macau_prior(trainSession, prior_type, side_info, config_item);
 }
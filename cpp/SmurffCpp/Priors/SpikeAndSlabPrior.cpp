@@ -90,26 +90,32 @@ void SpikeAndSlabPrior::restore(const SaveState &sf)
   update_prior();
 }
 
-std::pair<float_type, float_type> SpikeAndSlabPrior::sample_latent(int d, int k, const Matrix& XX, const Vector& yX)
+std::pair<float_type, float_type> SpikeAndSlabPrior::sample_latent(int d, int k, const Eigen::Ref<const Matrix> &XX, const Eigen::Ref<const Vector> &yX, Eigen::Ref<Vector> UXX)
 {
     const int v = data().view(m_mode, d);
-    float_type mu, lambda;
 
-    Matrix aXX = alpha.matrix().row(v).asDiagonal();
-    aXX += XX;
-    std::tie(mu, lambda) = NormalOnePrior::sample_latent(d, k, aXX, yX);
+    // switched off for the whole view: nothing to sample
+    if (Zkeep(v,k) <= 0) {
+        set_latent(d, k, .0, XX, UXX);
+        return std::make_pair(.0, .0);
+    }
+
+    // alpha is added to the diagonal of XX on the fly
+    float_type mu, lambda;
+    std::tie(mu, lambda) = cond_mu_lambda(d, k, XX, yX, UXX, alpha(v,k));
+    float_type u = mu + rand_normal() / sqrt(lambda);
 
-    auto Urow = U().row(d);
     float_type z1 = log_r(v,k) -  0.5 * (lambda * mu * mu - std::log(lambda) + log_alpha(v,k));
     float_type z = 1 / (1 + exp(z1));
     float_type p = rand_unif(0,1);
-    if (Zkeep(v,k) > 0 && p < z) {
+    if (p < z) {
         Zcol.local()(v,k)++;
-        W2col.local()(v,k) += Urow(k) * Urow(k);
+        W2col.local()(v,k) += u * u;
     } else {
-        Urow(k) = .0;
+        u = .0;
     }
 
+    set_latent(d, k, u, XX, UXX);
     return std::make_pair(mu, lambda);
 }
 
@@ -2,7 +2,6 @@
 
 #include <memory>
 
-#include <SmurffCpp/Types.h>
 #include <SmurffCpp/Types.h>
 
 #include <SmurffCpp/Utils/Distribution.h>
@@ -36,7 +35,7 @@ public:
 
    void restore(const SaveState &sf) override;
 
-   std::pair<float_type,float_type> sample_latent(int d, int k, const Matrix& XX, const Vector& yX) override;
+   std::pair<float_type,float_type> sample_latent(int d, int k, const Eigen::Ref<const Matrix> &XX, const Eigen::Ref<const Vector> &yX, Eigen::Ref<Vector> UXX) override;
 
    void update_prior() override;
 
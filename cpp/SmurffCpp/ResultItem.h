@@ -57,6 +57,28 @@ struct ResultItem
       pred_1sample = pred;
    }
 
+   // combine with n more samples, summarized by their mean avg, sum of
+   // squared deviations M2 and last prediction (Chan et al.)
+   void merge(double avg, double M2, int n, double last) {
+      if (n == 0)
+         return;
+
+      const int total = nsamples + n;
+      if (nsamples > 0)
+      {
+        double delta = avg - pred_avg;
+        pred_avg += delta * n / total;
+        var += M2 + delta * delta * nsamples * n / total;
+      }
+      else
+      {
+        pred_avg = avg;
+        var = M2;
+      }
+      nsamples = total;
+      pred_1sample = last;
+   }
+
    bool operator<(const ResultItem &other) const
    {
       return coords.as_vector() < other.coords.as_vector();
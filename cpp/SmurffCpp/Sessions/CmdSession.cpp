@@ -32,9 +32,14 @@ static const std::string BURNIN_NAME = "burnin";
 static const std::string NSAMPLES_NAME = "nsamples";
 static const std::string NUM_LATENT_NAME = "num-latent";
 static const std::string NUM_THREADS_NAME = "num-threads";
+static const std::string PIPELINED_EVAL_NAME = "pipelined-eval";
+static const std::string EVAL_THREADS_NAME = "eval-threads";
 static const std::string SAVE_NAME = "save-name";
 static const std::string SAVE_FREQ_NAME = "save-freq";
 static const std::string CHECKPOINT_FREQ_NAME = "checkpoint-freq";
+static const std::string SAVE_CHUNK_ROWS_NAME = "save-chunk-rows";
+static const std::string SAVE_DEFLATE_NAME = "save-deflate";
+static const std::string SAVE_SAMPLE_BITS_NAME = "save-sample-bits";
 static const std::string THRESHOLD_NAME = "threshold";
 static const std::string VERBOSE_NAME = "verbose";
 static const std::string VERSION_NAME = "version";
@@ -49,6 +54,8 @@ po::options_description get_desc()
 	(VERSION_NAME.c_str(), "print version info (and exit)")
 	(HELP_NAME.c_str(), "show this help information (and exit)")
 	(NUM_THREADS_NAME.c_str(), po::value<int>()->default_value(Config::NUM_THREADS_DEFAULT_VALUE), "number of threads (0 = default by OpenMP)")
+	(PIPELINED_EVAL_NAME.c_str(), po::value<bool>()->default_value(Config::PIPELINED_EVAL_DEFAULT_VALUE), "evaluate the test set while the next sample is drawn (status lags one iteration)")
+	(EVAL_THREADS_NAME.c_str(), po::value<int>()->default_value(Config::EVAL_THREADS_DEFAULT_VALUE), "threads of the pipelined evaluation, on top of num-threads")
 	(VERBOSE_NAME.c_str(), po::value<int>()->default_value(Config::VERBOSE_DEFAULT_VALUE), "verbosity of output (0, 1, 2 or 3)")
 	(SEED_NAME.c_str(), po::value<int>()->default_value(Config::RANDOM_SEED_DEFAULT_VALUE), "random number generator seed");
 
@@ -74,7 +81,10 @@ po::options_description get_desc()
 	(RESTORE_NAME.c_str(), po::value<std::string>(), "restore trainSession from a saved .h5 file")
 	(SAVE_NAME.c_str(), po::value<std::string>()->default_value(Config::SAVE_NAME_DEFAULT_VALUE), "save model and/or predictions to this .h5 file")
 	(SAVE_FREQ_NAME.c_str(), po::value<int>()->default_value(Config::SAVE_FREQ_DEFAULT_VALUE), "save every n iterations (0 == never, -1 == final model)")
-	(CHECKPOINT_FREQ_NAME.c_str(), po::value<int>()->default_value(Config::CHECKPOINT_FREQ_DEFAULT_VALUE), "save state every n seconds, only one checkpointing state is kept");
+	(CHECKPOINT_FREQ_NAME.c_str(), po::value<int>()->default_value(Config::CHECKPOINT_FREQ_DEFAULT_VALUE), "save state every n seconds, only one checkpointing state is kept")
+	(SAVE_CHUNK_ROWS_NAME.c_str(), po::value<int>()->default_value(Config::SAVE_CHUNK_ROWS_DEFAULT_VALUE), "rows per chunk of saved matrices (0 == about 1MB per chunk)")
+	(SAVE_DEFLATE_NAME.c_str(), po::value<int>()->default_value(Config::SAVE_DEFLATE_DEFAULT_VALUE), "gzip level of saved matrices (0 == uncompressed, 1-9)")
+	(SAVE_SAMPLE_BITS_NAME.c_str(), po::value<int>()->default_value(Config::SAVE_SAMPLE_BITS_DEFAULT_VALUE), "store saved samples as 32 or 16 bit floats (0 == full precision)");
 
     po::options_description desc("SMURFF: Scalable Matrix Factorization Framework\n\thttp://github.com/ExaScience/smurff");
     desc.add(general_desc);
@@ -159,10 +169,15 @@ fill_config(const po::variables_map &vm)
     filler.set<int,         &Config::setNSamples>(NSAMPLES_NAME);
     filler.set<int,         &Config::setNumLatent>(NUM_LATENT_NAME);
     filler.set<int,         &Config::setNumThreads>(NUM_THREADS_NAME);
+    filler.set<bool,        &Config::setPipelinedEval>(PIPELINED_EVAL_NAME);
+    filler.set<int,         &Config::setEvalThreads>(EVAL_THREADS_NAME);
     filler.set<std::string, &Config::setRestoreName>(RESTORE_NAME);
     filler.set<std::string, &Config::setSaveName>(SAVE_NAME);
     filler.set<int,         &Config::setSaveFreq>(SAVE_FREQ_NAME);
     filler.set<int,         &Config::setCheckpointFreq>(CHECKPOINT_FREQ_NAME);
+    filler.set<int,         &Config::setSaveChunkRows>(SAVE_CHUNK_ROWS_NAME);
+    filler.set<int,         &Config::setSaveDeflate>(SAVE_DEFLATE_NAME);
+    filler.set<int,         &Config::setSaveSampleBits>(SAVE_SAMPLE_BITS_NAME);
     filler.set<double,      &Config::setThreshold>(THRESHOLD_NAME);
     filler.set<int,         &Config::setVerbose>(VERBOSE_NAME);
     filler.set<int,         &Config::setRandomSeed>(SEED_NAME);
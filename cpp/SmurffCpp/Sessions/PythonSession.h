@@ -24,6 +24,9 @@ public:
    void setSaveFreq(int value) { m_config.setSaveFreq(value); } 
    void setSavePred(bool value) { m_config.setSavePred(value); } 
    void setCheckpointFreq(int value) { m_config.setCheckpointFreq(value); } 
+   void setSaveChunkRows(int value) { m_config.setSaveChunkRows(value); }
+   void setSaveDeflate(int value) { m_config.setSaveDeflate(value); }
+   void setSaveSampleBits(int value) { m_config.setSaveSampleBits(value); }
    void setRandomSeed(int value) { m_config.setRandomSeed(value); } 
    void setVerbose(int value) { m_config.setVerbose(value); } 
    void setBurnin(int value) { m_config.setBurnin(value); } 
@@ -31,6 +34,8 @@ public:
    void setNumLatent(int value) { m_config.setNumLatent(value); } 
    void setThreshold(double value) { m_config.setThreshold(value); } 
    void setNumThreads(int value) { m_config.setNumThreads(value); }
+   void setPipelinedEval(bool value) { m_config.setPipelinedEval(value); }
+   void setEvalThreads(int value) { m_config.setEvalThreads(value); }
 
    template <typename SparseType>
    void setTest(const SparseType &data)
@@ -46,20 +51,22 @@ public:
        train.setNoiseConfig(nc);
    }
 
-   void addSideInfoDense(int mode, const Matrix &data, const NoiseConfig &nc, bool direct) 
+   void addSideInfoDense(int mode, const Matrix &data, const NoiseConfig &nc, bool direct, bool mixed_precision) 
    {
       auto &si = m_config.addSideInfo(mode);
       si.setData(data);
       si.setNoiseConfig(nc);
       si.setDirect(direct);
+      si.setMixedPrecision(mixed_precision);
    }
 
-   void addSideInfoSparse(int mode, const SparseMatrix &data, const NoiseConfig &nc, bool direct) 
+   void addSideInfoSparse(int mode, const SparseMatrix &data, const NoiseConfig &nc, bool direct, bool mixed_precision) 
    {
       auto &si = m_config.addSideInfo(mode);
       si.setData(data, false);
       si.setNoiseConfig(nc);
       si.setDirect(direct);
+      si.setMixedPrecision(mixed_precision);
    }
 
    template <typename DenseType>
@@ -1,6 +1,7 @@
 #include "TrainSession.h"
 
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <iomanip>
@@ -31,12 +32,20 @@ void TrainSession::init()
         // create state file
         m_stateFile = std::make_shared<StateFile>(getConfig().getSaveName(), true);
 
+        HDF5Group::StorageOptions options;
+        options.chunk_rows = getConfig().getSaveChunkRows();
+        options.deflate = getConfig().getSaveDeflate();
+        options.sample_bits = getConfig().getSaveSampleBits();
+        m_stateFile->setStorageOptions(options);
+
         //save config
         m_stateFile->saveConfig(getConfig());
 
         // close stateFile is we do not need it anymore
         if (!getConfig().getSaveFreq() && !getConfig().getCheckpointFreq())
             m_stateFile.reset();
+        else
+            m_writer = std::make_unique<BackgroundWriter>();
     }
 
     // initialize pred
@@ -46,6 +55,8 @@ void TrainSession::init()
         m_pred.setSavePred(getConfig().getSavePred());
         if (getConfig().getClassify())
             m_pred.setThreshold(getConfig().getThreshold());
+        if (getConfig().getPipelinedEval())
+            m_evaluator = std::make_unique<BackgroundWriter>(1);
     }
 
     // init data
@@ -125,8 +136,7 @@ bool TrainSession::step()
         data().update(model());
         auto endi = tick();
 
-        //WARNING: update is an expensive operation because of sort (when calculating AUC)
-        m_pred.update(m_model, m_iter < getConfig().getBurnin());
+        evaluate();
 
         m_secs_per_iter = endi - starti;
         m_secs_total += m_secs_per_iter;
@@ -162,6 +172,47 @@ std::ostream &TrainSession::info(std::ostream &os, std::string indent) const
     return os;
 }
 
+void TrainSession::evaluate()
+{
+    bool burnin = m_iter < getConfig().getBurnin();
+
+    if (!m_evaluator)
+    {
+        //WARNING: update is an expensive operation because of sort (when calculating AUC)
+        m_pred.update(m_model, burnin);
+        updateScores();
+        return;
+    }
+
+    // the previous sample is evaluated, report its scores in this iteration
+    m_evaluator->flush();
+    updateScores();
+
+    // evaluate this sample on a snapshot, on the evaluator's threads,
+    // while the sampler continues with the next one
+    auto model = m_model.snapshot(false);
+    const int nthreads = getConfig().getEvalThreads();
+    m_evaluator->push([this, model, burnin, nthreads]() {
+        threads::set_num_threads(nthreads);
+        m_pred.update(*model, burnin);
+    });
+
+    // no lag for the final sample
+    if (m_iter == getConfig().getBurnin() + getConfig().getNSamples() - 1)
+    {
+        m_evaluator->flush();
+        updateScores();
+    }
+}
+
+void TrainSession::updateScores()
+{
+    m_scores.rmse_avg = m_pred.rmse_avg;
+    m_scores.rmse_1sample = m_pred.rmse_1sample;
+    m_scores.auc_avg = m_pred.auc_avg;
+    m_scores.auc_1sample = m_pred.auc_1sample;
+}
+
 void TrainSession::save()
 {
     //do not save if 'never save' mode is selected
@@ -183,12 +234,9 @@ void TrainSession::save()
     {
         std::int32_t icheckpoint = m_iter + 1;
 
-        //save this iteration
+        //save this iteration, also removes the previous checkpoint
         saveInternal(icheckpoint, true);
 
-        //remove previous iteration if required (initial m_lastCheckpointIter is -1 which means that it does not exist)
-        m_stateFile->removeOldCheckpoints();
-
         //upddate counters
         m_lastCheckpointTime = tick();
         m_lastCheckpointIter = m_iter;
@@ -214,30 +262,62 @@ void TrainSession::save()
         }
     }
 
-    // close after final step
-    if (m_iter == niter - 1) m_stateFile.reset();
+    // close after final step, once everything is written
+    if (m_iter == niter - 1)
+    {
+        if (m_writer) m_writer->flush();
+        m_writer.reset();
+        m_stateFile.reset();
+    }
 }
 
 void TrainSession::saveInternal(int iteration, bool checkpoint)
 {
     bool final = iteration == getConfig().getNSamples();
-    SaveState saveState = m_stateFile->createStep(iteration, checkpoint, final || checkpoint);
+    bool save_aggr = final || checkpoint;
+    bool verbose = getConfig().getVerbose();
 
-    if (getConfig().getVerbose())
-    {
-        std::cout << "-- Saving model, predictions,... into '" << m_stateFile->getPath() << "'." << std::endl;
-    }
-    double start = tick();
+    // predictions of this sample must be complete
+    if (m_evaluator) m_evaluator->flush();
 
-    m_model.save(saveState);
-    m_pred.save(saveState);
-    for (auto &p : m_priors) p->save(saveState);
+    // take a snapshot here, serialize it on the writer thread
+    auto model = m_model.snapshot(save_aggr);
+    auto pred = std::make_shared<const Result>(m_pred);
+    auto priors = m_priors; // priors keep no sampled state outside the model
+    auto stateFile = m_stateFile;
 
-    double stop = tick();
-    if (getConfig().getVerbose())
-    {
-        std::cout << "-- Done saving model. Took " << stop - start << " seconds." << std::endl;
-    }
+    // one thread next to the sampler, all of them once sampling is done
+    int nthreads = final ? threads::get_max_threads() : 1;
+
+    m_writer->push([=]() {
+        threads::set_num_threads(nthreads);
+
+        if (verbose)
+        {
+            std::cout << "-- Saving model, predictions,... into '" << stateFile->getPath() << "'." << std::endl;
+        }
+        double start = tick();
+
+        {
+            SaveState saveState = stateFile->createStep(iteration, checkpoint, save_aggr);
+            model->save(saveState);
+            pred->save(saveState);
+            for (auto &p : priors) p->save(saveState);
+        }
+
+        if (!checkpoint)
+            stateFile->indexSampleStep(iteration);
+
+        //remove previous checkpoint (if there is one)
+        if (checkpoint)
+            stateFile->removeOldCheckpoints();
+
+        double stop = tick();
+        if (verbose)
+        {
+            std::cout << "-- Done saving model. Took " << stop - start << " seconds." << std::endl;
+        }
+    });
 }
 
 bool TrainSession::restore(int &iteration)
@@ -264,6 +344,7 @@ bool TrainSession::restore(int &iteration)
 
     m_model.restore(saveState);
     m_pred.restore(saveState);
+    updateScores();
     for (auto &p : m_priors)
         p->restore(saveState);
 
@@ -290,6 +371,7 @@ bool TrainSession::restore(int &iteration)
 
 const Result &TrainSession::getResult() const
 {
+   if (m_evaluator) m_evaluator->flush();
    return m_pred;
 }
 
@@ -325,11 +407,11 @@ StatusItem TrainSession::getStatus() const
 
     ret.train_rmse = data().train_rmse(model());
 
-    ret.rmse_avg = m_pred.rmse_avg;
-    ret.rmse_1sample = m_pred.rmse_1sample;
+    ret.rmse_avg = m_scores.rmse_avg;
+    ret.rmse_1sample = m_scores.rmse_1sample;
 
-    ret.auc_avg = m_pred.auc_avg;
-    ret.auc_1sample = m_pred.auc_1sample;
+    ret.auc_avg = m_scores.auc_avg;
+    ret.auc_1sample = m_scores.auc_1sample;
 
     ret.elapsed_iter = m_secs_per_iter;
     ret.elapsed_total = m_secs_total;
@@ -2,11 +2,13 @@
 
 #include <iostream>
 #include <memory>
+#include <cmath>
 
 #include <SmurffCpp/Utils/Error.h>
 #include <SmurffCpp/Configs/Config.h>
 #include <SmurffCpp/Priors/IPriorFactory.h>
 #include <SmurffCpp/Utils/StateFile.h>
+#include <SmurffCpp/Utils/BackgroundWriter.h>
 #include <SmurffCpp/StatusItem.h>
 #include <SmurffCpp/Sessions/ISession.h>
 #include <SmurffCpp/Model.h>
@@ -34,6 +36,20 @@ protected:
 
 private:
    std::shared_ptr<StateFile> m_stateFile;
+   // writes snapshots to m_stateFile while sampling continues
+   std::unique_ptr<BackgroundWriter> m_writer;
+   // evaluates the test set on a snapshot while the next sample is drawn,
+   // on threads taken from the sampler
+   std::unique_ptr<BackgroundWriter> m_evaluator;
+
+   // test scores reported by getStatus(), lag one iteration when pipelined
+   struct Scores
+   {
+      double rmse_avg = NAN;
+      double rmse_1sample = NAN;
+      double auc_avg = NAN;
+      double auc_1sample = NAN;
+   } m_scores;
 
 private:
    int m_iter = -1; //index of step iteration
@@ -60,6 +76,12 @@ public:
    std::ostream &info(std::ostream &, std::string indent) const override;
 
 private:
+   //update predictions of the test set with the current sample
+   void evaluate();
+
+   //copy the test scores from m_pred
+   void updateScores();
+
    //save current iteration
    void save();
 
@@ -0,0 +1,154 @@
+#include "BinarySparseSideInfo.h"
+#include "linop.h"
+#include "FeatureGroups.h"
+
+#include <SmurffCpp/Utils/Error.h>
+#include <SmurffCpp/Utils/counters.h>
+
+namespace smurff {
+
+static void make_pattern(BinarySparseSideInfo::Pattern &p, const SparseMatrix &M)
+{
+   THROWERROR_ASSERT(M.isCompressed());
+
+   p.nrows = M.rows();
+   p.ncols = M.cols();
+   p.outer.assign(M.outerIndexPtr(), M.outerIndexPtr() + M.outerSize() + 1);
+   p.inner.assign(M.innerIndexPtr(), M.innerIndexPtr() + M.nonZeros());
+}
+
+// out = P * B, where P is a 0/1 pattern
+static void pattern_mul_B(Matrix &out, const BinarySparseSideInfo::Pattern &P, const Matrix &B)
+{
+   THROWERROR_ASSERT(P.ncols == B.rows());
+
+   out.resize(P.nrows, B.cols());
+
+   #pragma omp parallel for schedule(guided)
+   for (int i = 0; i < P.nrows; ++i)
+   {
+      auto out_row = out.row(i);
+      out_row.setZero();
+      for (int j = P.outer[i]; j < P.outer[i + 1]; ++j)
+         out_row += B.row(P.inner[j]);
+   }
+}
+
+BinarySparseSideInfo::BinarySparseSideInfo(const DataConfig &mc)
+{
+   SparseMatrix M = mc.getSparseMatrixData();
+   M.makeCompressed();
+   make_pattern(F, M);
+
+   SparseMatrix Mt = M.transpose();
+   Mt.makeCompressed();
+   make_pattern(Ft, Mt);
+}
+
+BinarySparseSideInfo::~BinarySparseSideInfo() {}
+
+int BinarySparseSideInfo::cols() const
+{
+   return F.ncols;
+}
+
+int BinarySparseSideInfo::rows() const
+{
+   return F.nrows;
+}
+
+std::ostream& BinarySparseSideInfo::print(std::ostream &os) const
+{
+   double percent = 100.0 * (double)F.nnz() / (double)F.nrows / (double)F.ncols;
+   os << "SparseBinary " << F.nnz() << " [" << F.nrows << ", " << F.ncols << "] ("
+      << percent << "%)" << std::endl;
+   return os;
+}
+
+bool BinarySparseSideInfo::is_dense() const
+{
+   return false;
+}
+
+void BinarySparseSideInfo::F_mul_B(Matrix& out, const Matrix& B) const
+{
+   pattern_mul_B(out, F, B);
+}
+
+void BinarySparseSideInfo::Ft_mul_B(Matrix& out, const Matrix& B) const
+{
+   pattern_mul_B(out, Ft, B);
+}
+
+void BinarySparseSideInfo::compute_uhat(Matrix& uhat, Matrix& beta)
+{
+   COUNTER("compute_uhat");
+   F_mul_B(uhat, beta);
+}
+
+// out(a,b) = number of items that have both feature a and feature b
+void BinarySparseSideInfo::At_mul_A(Matrix& out)
+{
+   COUNTER("At_mul_A");
+   out.resize(Ft.nrows, Ft.nrows);
+
+   #pragma omp parallel for schedule(guided)
+   for (int a = 0; a < Ft.nrows; ++a)
+   {
+      auto out_row = out.row(a);
+      out_row.setZero();
+      for (int i = Ft.outer[a]; i < Ft.outer[a + 1]; ++i)
+      {
+         const int item = Ft.inner[i];
+         for (int j = F.outer[item]; j < F.outer[item + 1]; ++j)
+            out_row(F.inner[j]) += 1.0;
+      }
+   }
+}
+
+Matrix BinarySparseSideInfo::A_mul_B(Matrix& A)
+{
+   COUNTER("A_mul_B");
+   Matrix out;
+   Ft_mul_B(out, A);
+   return out;
+}
+
+int BinarySparseSideInfo::solve_blockcg(Matrix& X, double reg, Matrix& B, double tol, const int blocksize, const int excess, bool throw_on_cholesky_error)
+{
+   COUNTER("solve_blockcg");
+   return linop::solve_blockcg(X, *this, reg, B, tol, blocksize, excess, throw_on_cholesky_error);
+}
+
+// square of a one is one: count ones per column
+Vector BinarySparseSideInfo::col_square_sum()
+{
+   COUNTER("col_square_sum");
+   Vector out(Ft.nrows);
+   for (int f = 0; f < Ft.nrows; ++f)
+      out(f) = Ft.outer[f + 1] - Ft.outer[f];
+   return out;
+}
+
+// Y = X[:,col]' * B
+void BinarySparseSideInfo::At_mul_Bt(Vector& Y, const int col, Matrix& B)
+{
+   COUNTER("At_mul_Bt");
+   Y.setZero(B.cols());
+   for (int i = Ft.outer[col]; i < Ft.outer[col + 1]; ++i)
+      Y += B.row(Ft.inner[i]);
+}
+
+// computes Z += A[:,col] * b', where a and b are vectors
+void BinarySparseSideInfo::add_Acol_mul_bt(Matrix& Z, const int col, Vector& b)
+{
+   COUNTER("add_Acol_mul_bt");
+   for (int i = Ft.outer[col]; i < Ft.outer[col + 1]; ++i)
+      Z.row(Ft.inner[i]) += b;
+}
+
+std::vector<std::vector<int>> BinarySparseSideInfo::feature_groups() const
+{
+   return color_features(F.ncols, F.outer.data(), F.inner.data(), Ft.outer.data(), Ft.inner.data());
+}
+} // end namespace smurff
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <SmurffCpp/Types.h>
+#include <SmurffCpp/Configs/DataConfig.h>
+
+#include "ISideInfo.h"
+
+namespace smurff {
+
+// Side info with only 0/1 values (e.g. fingerprints)
+// Only the positions of the ones are stored, all kernels are add-only.
+class BinarySparseSideInfo : public ISideInfo
+{
+public:
+   // compressed row storage without values
+   struct Pattern
+   {
+      int nrows = 0;
+      int ncols = 0;
+      std::vector<int> outer; // nrows + 1 offsets into inner
+      std::vector<int> inner; // column index of each one
+
+      int nnz() const { return inner.size(); }
+   };
+
+   Pattern F;  // num_item x num_feat
+   Pattern Ft; // num_feat x num_item
+
+   BinarySparseSideInfo(const DataConfig &);
+   ~BinarySparseSideInfo() override;
+
+public:
+   int cols() const override;
+   int rows() const override;
+
+public:
+   std::ostream& print(std::ostream &os) const override;
+
+   bool is_dense() const override;
+
+public:
+   //linop
+
+   void compute_uhat(Matrix& uhat, Matrix& beta) override;
+
+   void At_mul_A(Matrix& out) override;
+
+   Matrix A_mul_B(Matrix& A) override;
+
+   int solve_blockcg(Matrix& X, double reg, Matrix& B, double tol, const int blocksize, const int excess, bool throw_on_cholesky_error = false) override;
+
+   Vector col_square_sum() override;
+
+   void At_mul_Bt(Vector& Y, const int row, Matrix& B) override;
+
+   void add_Acol_mul_bt(Matrix& Z, const int row, Vector& b) override;
+
+   std::vector<std::vector<int>> feature_groups() const override;
+
+public:
+   // out = F * B
+   void F_mul_B(Matrix& out, const Matrix& B) const;
+
+   // out = F' * B
+   void Ft_mul_B(Matrix& out, const Matrix& B) const;
+};
+
+}
@@ -59,7 +59,7 @@ Vector DenseSideInfo::col_square_sum()
 
 void DenseSideInfo::At_mul_Bt(Vector& Y, const int feat, Matrix& B)
 {
-   Y = m_side_info.col(feat).transpose() * B;
+   Y.noalias() = m_side_info.col(feat).transpose() * B;
 }
 
 void DenseSideInfo::add_Acol_mul_bt(Matrix& Z, const int row, Vector& b)
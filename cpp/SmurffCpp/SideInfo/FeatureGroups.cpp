@@ -0,0 +1,40 @@
+#include "FeatureGroups.h"
+
+namespace smurff {
+
+std::vector<std::vector<int>> color_features(int nfeat,
+                                             const int *f_outer, const int *f_inner,
+                                             const int *ft_outer, const int *ft_inner)
+{
+   std::vector<std::vector<int>> groups;
+   std::vector<int> color(nfeat, -1);
+   std::vector<int> forbidden; // forbidden[c] == f: color c is taken by a neighbour of f
+
+   for (int f = 0; f < nfeat; ++f)
+   {
+      for (int i = ft_outer[f]; i < ft_outer[f + 1]; ++i)
+      {
+         const int item = ft_inner[i];
+         for (int j = f_outer[item]; j < f_outer[item + 1]; ++j)
+         {
+            const int c = color[f_inner[j]];
+            if (c >= 0) forbidden[c] = f;
+         }
+      }
+
+      int c = 0;
+      while (c < (int)groups.size() && forbidden[c] == f) ++c;
+      if (c == (int)groups.size())
+      {
+         groups.emplace_back();
+         forbidden.push_back(-1);
+      }
+
+      color[f] = c;
+      groups[c].push_back(f);
+   }
+
+   return groups;
+}
+
+}
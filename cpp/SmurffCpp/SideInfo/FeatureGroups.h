@@ -0,0 +1,17 @@
+#pragma once
+
+#include <vector>
+
+namespace smurff {
+
+// Greedy coloring of the feature co-occurrence graph.
+// Two features conflict when they are both non-zero for the same item.
+// Returns groups of features where no two features in a group conflict.
+//
+//  f_outer/f_inner   - compressed rows of F  (item -> features)
+//  ft_outer/ft_inner - compressed rows of F' (feature -> items)
+std::vector<std::vector<int>> color_features(int nfeat,
+                                             const int *f_outer, const int *f_inner,
+                                             const int *ft_outer, const int *ft_inner);
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <vector>
 
 #include <SmurffCpp/Types.h>
 
@@ -35,6 +36,16 @@ namespace smurff {
       virtual void At_mul_Bt(Vector& Y, const int row, Matrix& B) = 0;
 
       virtual void add_Acol_mul_bt(Matrix& Z, const int row, Vector& b) = 0;
+
+      // groups of features that never share an item, so that
+      // At_mul_Bt/add_Acol_mul_bt can run in parallel within a group
+      // default: every feature on its own
+      virtual std::vector<std::vector<int>> feature_groups() const
+      {
+         std::vector<std::vector<int>> groups(cols());
+         for (int f = 0; f < cols(); ++f) groups[f].push_back(f);
+         return groups;
+      }
    };
 
 }
@@ -0,0 +1,145 @@
+#include "MixedSparseSideInfo.h"
+#include "linop.h"
+#include "FeatureGroups.h"
+
+#include <SmurffCpp/Utils/Error.h>
+#include <SmurffCpp/Utils/counters.h>
+
+namespace smurff {
+
+// out = M * B, with M in float and B, out in double
+static void mixed_mul_B(Matrix &out, const SparseMatrixF &M, const Matrix &B)
+{
+   THROWERROR_ASSERT(M.cols() == B.rows());
+
+   out.resize(M.rows(), B.cols());
+
+   #pragma omp parallel for schedule(guided)
+   for (int i = 0; i < M.outerSize(); ++i)
+   {
+      auto out_row = out.row(i);
+      out_row.setZero();
+      for (SparseMatrixF::InnerIterator it(M, i); it; ++it)
+         out_row += (float_type)it.value() * B.row(it.col());
+   }
+}
+
+MixedSparseSideInfo::MixedSparseSideInfo(const DataConfig &mc)
+{
+   F = mc.getSparseMatrixData().cast<float>();
+   F.makeCompressed();
+   Ft = F.transpose();
+   Ft.makeCompressed();
+}
+
+MixedSparseSideInfo::~MixedSparseSideInfo() {}
+
+int MixedSparseSideInfo::cols() const
+{
+   return F.cols();
+}
+
+int MixedSparseSideInfo::rows() const
+{
+   return F.rows();
+}
+
+std::ostream& MixedSparseSideInfo::print(std::ostream &os) const
+{
+   double percent = 100.0 * (double)F.nonZeros() / (double)F.rows() / (double)F.cols();
+   os << "SparseFloat " << F.nonZeros() << " [" << F.rows() << ", " << F.cols() << "] ("
+      << percent << "%)" << std::endl;
+   return os;
+}
+
+bool MixedSparseSideInfo::is_dense() const
+{
+   return false;
+}
+
+void MixedSparseSideInfo::F_mul_B(Matrix& out, const Matrix& B) const
+{
+   mixed_mul_B(out, F, B);
+}
+
+void MixedSparseSideInfo::Ft_mul_B(Matrix& out, const Matrix& B) const
+{
+   mixed_mul_B(out, Ft, B);
+}
+
+void MixedSparseSideInfo::compute_uhat(Matrix& uhat, Matrix& beta)
+{
+   COUNTER("compute_uhat");
+   F_mul_B(uhat, beta);
+}
+
+// out = F' * F, one row of the Gram matrix per feature
+void MixedSparseSideInfo::At_mul_A(Matrix& out)
+{
+   COUNTER("At_mul_A");
+   out.resize(Ft.rows(), Ft.rows());
+
+   #pragma omp parallel for schedule(guided)
+   for (int a = 0; a < Ft.outerSize(); ++a)
+   {
+      auto out_row = out.row(a);
+      out_row.setZero();
+      for (SparseMatrixF::InnerIterator it(Ft, a); it; ++it)
+      {
+         const float_type v = it.value();
+         for (SparseMatrixF::InnerIterator jt(F, it.col()); jt; ++jt)
+            out_row(jt.col()) += v * (float_type)jt.value();
+      }
+   }
+}
+
+Matrix MixedSparseSideInfo::A_mul_B(Matrix& A)
+{
+   COUNTER("A_mul_B");
+   Matrix out;
+   Ft_mul_B(out, A);
+   return out;
+}
+
+int MixedSparseSideInfo::solve_blockcg(Matrix& X, double reg, Matrix& B, double tol, const int blocksize, const int excess, bool throw_on_cholesky_error)
+{
+   COUNTER("solve_blockcg");
+   return linop::solve_blockcg(X, *this, reg, B, tol, blocksize, excess, throw_on_cholesky_error);
+}
+
+Vector MixedSparseSideInfo::col_square_sum()
+{
+   COUNTER("col_square_sum");
+   Vector out(Ft.rows());
+   for (int f = 0; f < Ft.outerSize(); ++f)
+   {
+      double sum = 0.0;
+      for (SparseMatrixF::InnerIterator it(Ft, f); it; ++it)
+         sum += (float_type)it.value() * (float_type)it.value();
+      out(f) = sum;
+   }
+   return out;
+}
+
+// Y = X[:,col]' * B
+void MixedSparseSideInfo::At_mul_Bt(Vector& Y, const int col, Matrix& B)
+{
+   COUNTER("At_mul_Bt");
+   Y.setZero(B.cols());
+   for (SparseMatrixF::InnerIterator it(Ft, col); it; ++it)
+      Y += (float_type)it.value() * B.row(it.col());
+}
+
+// computes Z += A[:,col] * b', where a and b are vectors
+void MixedSparseSideInfo::add_Acol_mul_bt(Matrix& Z, const int col, Vector& b)
+{
+   COUNTER("add_Acol_mul_bt");
+   for (SparseMatrixF::InnerIterator it(Ft, col); it; ++it)
+      Z.row(it.col()) += (float_type)it.value() * b;
+}
+
+std::vector<std::vector<int>> MixedSparseSideInfo::feature_groups() const
+{
+   return color_features(F.cols(), F.outerIndexPtr(), F.innerIndexPtr(), Ft.outerIndexPtr(), Ft.innerIndexPtr());
+}
+} // end namespace smurff
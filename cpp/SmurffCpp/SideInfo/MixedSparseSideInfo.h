@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <SmurffCpp/Types.h>
+#include <SmurffCpp/Configs/DataConfig.h>
+
+#include "ISideInfo.h"
+
+namespace smurff {
+
+// Sparse side info stored in single precision
+// Products read float values but accumulate in double, except
+// for the inner block-CG iterations which run completely in float
+// and are corrected by iterative refinement (see linop::solve_blockcg).
+class MixedSparseSideInfo : public ISideInfo
+{
+public:
+   SparseMatrixF F;  // num_item x num_feat
+   SparseMatrixF Ft; // num_feat x num_item
+
+   MixedSparseSideInfo(const DataConfig &);
+   ~MixedSparseSideInfo() override;
+
+public:
+   int cols() const override;
+   int rows() const override;
+
+public:
+   std::ostream& print(std::ostream &os) const override;
+
+   bool is_dense() const override;
+
+public:
+   //linop
+
+   void compute_uhat(Matrix& uhat, Matrix& beta) override;
+
+   void At_mul_A(Matrix& out) override;
+
+   Matrix A_mul_B(Matrix& A) override;
+
+   int solve_blockcg(Matrix& X, double reg, Matrix& B, double tol, const int blocksize, const int excess, bool throw_on_cholesky_error = false) override;
+
+   Vector col_square_sum() override;
+
+   void At_mul_Bt(Vector& Y, const int row, Matrix& B) override;
+
+   void add_Acol_mul_bt(Matrix& Z, const int row, Vector& b) override;
+
+   std::vector<std::vector<int>> feature_groups() const override;
+
+public:
+   // out = F * B, double accumulation
+   void F_mul_B(Matrix& out, const Matrix& B) const;
+
+   // out = F' * B, double accumulation
+   void Ft_mul_B(Matrix& out, const Matrix& B) const;
+};
+
+}
@@ -1,15 +1,73 @@
 #include "SparseSideInfo.h"
 #include "linop.h"
+#include "FeatureGroups.h"
 
 #include <SmurffCpp/Utils/MatrixUtils.h>
+#include <SmurffCpp/Utils/Error.h>
+#include <SmurffCpp/Utils/counters.h>
 
 #include <vector>
+#include <algorithm>
 
 namespace smurff {
 
+// rows per OpenMP work item in the kernels below
+static const int ROW_BLOCK = 64;
+
+// out = M * B, parallel over blocks of rows of M
+static void spmm(Matrix &out, const SparseMatrix &M, const Matrix &B)
+{
+   COUNTER("spmm");
+   THROWERROR_ASSERT(M.cols() == B.rows());
+
+   const int nrows = M.rows();
+   const int nblocks = (nrows + ROW_BLOCK - 1) / ROW_BLOCK;
+   out.resize(nrows, B.cols());
+
+   #pragma omp parallel for schedule(guided)
+   for (int block = 0; block < nblocks; ++block)
+   {
+      const int end = std::min(nrows, (block + 1) * ROW_BLOCK);
+      for (int i = block * ROW_BLOCK; i < end; ++i)
+      {
+         auto out_row = out.row(i);
+         out_row.setZero();
+         for (SparseMatrix::InnerIterator it(M, i); it; ++it)
+            out_row += it.value() * B.row(it.col());
+      }
+   }
+}
+
+// out = Mt * M, one dense row of the Gram matrix per row of Mt
+static void gram(Matrix &out, const SparseMatrix &Mt, const SparseMatrix &M)
+{
+   COUNTER("gram");
+   THROWERROR_ASSERT(Mt.cols() == M.rows());
+
+   const int nrows = Mt.rows();
+   const int nblocks = (nrows + ROW_BLOCK - 1) / ROW_BLOCK;
+   out.resize(nrows, M.cols());
+
+   #pragma omp parallel for schedule(guided)
+   for (int block = 0; block < nblocks; ++block)
+   {
+      const int end = std::min(nrows, (block + 1) * ROW_BLOCK);
+      for (int a = block * ROW_BLOCK; a < end; ++a)
+      {
+         auto out_row = out.row(a);
+         out_row.setZero();
+         for (SparseMatrix::InnerIterator it(Mt, a); it; ++it)
+            for (SparseMatrix::InnerIterator jt(M, it.col()); jt; ++jt)
+               out_row(jt.col()) += it.value() * jt.value();
+      }
+   }
+}
+
 SparseSideInfo::SparseSideInfo(const DataConfig &mc) {
     F = mc.getSparseMatrixData();
+    F.makeCompressed();
     Ft = F.transpose();
+    Ft.makeCompressed();
 }
 
 SparseSideInfo::~SparseSideInfo() {}
@@ -38,22 +96,34 @@ bool SparseSideInfo::is_dense() const
    return false;
 }
 
+void SparseSideInfo::F_mul_B(Matrix& out, const Matrix& B) const
+{
+    spmm(out, F, B);
+}
+
+void SparseSideInfo::Ft_mul_B(Matrix& out, const Matrix& B) const
+{
+    spmm(out, Ft, B);
+}
+
 void SparseSideInfo::compute_uhat(Matrix& uhat, Matrix& beta)
 {
     COUNTER("compute_uhat");
-    uhat = F * beta;
+    F_mul_B(uhat, beta);
 }
 
 void SparseSideInfo::At_mul_A(Matrix& out)
 {
     COUNTER("At_mul_A");
-    out = Ft * F;
+    gram(out, Ft, F);
 }
 
 Matrix SparseSideInfo::A_mul_B(Matrix& A)
 {
     COUNTER("A_mul_B");
-    return F.transpose() * A;
+    Matrix out;
+    Ft_mul_B(out, A);
+    return out;
 }
 
 int SparseSideInfo::solve_blockcg(Matrix& X, double reg, Matrix& B, double tol, const int blocksize, const int excess, bool throw_on_cholesky_error)
@@ -75,13 +145,21 @@ Vector SparseSideInfo::col_square_sum()
 void SparseSideInfo::At_mul_Bt(Vector& Y, const int row, Matrix& B)
 {
     COUNTER("At_mul_Bt");
-    Y = Ft.row(row) * B;
+    Y.setZero(B.cols());
+    for (SparseMatrix::InnerIterator it(Ft, row); it; ++it)
+        Y += it.value() * B.row(it.col());
 }
 
 // computes Z += A[:,row] * b', where a and b are vectors
 void SparseSideInfo::add_Acol_mul_bt(Matrix& Z, const int col, Vector& b)
 {
     COUNTER("add_Acol_mul_bt");
-    Z += F.col(col) * b;
+    for (SparseMatrix::InnerIterator it(Ft, col); it; ++it)
+        Z.row(it.col()) += it.value() * b;
+}
+
+std::vector<std::vector<int>> SparseSideInfo::feature_groups() const
+{
+    return color_features(F.cols(), F.outerIndexPtr(), F.innerIndexPtr(), Ft.outerIndexPtr(), Ft.innerIndexPtr());
 }
 } // end namespace smurff
@@ -2,6 +2,7 @@
 
 
 #include <memory>
+#include <vector>
 #include <SmurffCpp/Types.h>
 #include <SmurffCpp/Configs/DataConfig.h>
 
@@ -44,6 +45,14 @@ public:
 
    void add_Acol_mul_bt(Matrix& Z, const int row, Vector& b) override;
 
+   std::vector<std::vector<int>> feature_groups() const override;
+
+public:
+   // out = F * B, multithreaded
+   void F_mul_B(Matrix& out, const Matrix& B) const;
+
+   // out = F' * B, multithreaded
+   void Ft_mul_B(Matrix& out, const Matrix& B) const;
 };
 
 }
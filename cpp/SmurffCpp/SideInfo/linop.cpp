@@ -1,3 +1,5 @@
+#include <type_traits>
+
 #include <SmurffCpp/Types.h>
 #include <Eigen/IterativeLinearSolvers>
 
@@ -6,6 +8,8 @@
 #include <SmurffCpp/Utils/counters.h>
 
 #include <SmurffCpp/SideInfo/SparseSideInfo.h>
+#include <SmurffCpp/SideInfo/BinarySparseSideInfo.h>
+#include <SmurffCpp/SideInfo/MixedSparseSideInfo.h>
 #include "linop.h"
 
 namespace smurff {
@@ -85,13 +89,40 @@ namespace smurff
 namespace linop
 {
 
-inline void makeSymmetric(Matrix &A)
+template<typename M>
+inline void makeSymmetric(M &A)
 {
-  A = A.selfadjointView<Eigen::Lower>();
+  A = A.template selfadjointView<Eigen::Lower>();
 }
 
 inline void AtA_mul_B(Matrix& out, const SparseSideInfo& A, double reg, const Matrix& B) {
-  out.noalias() = (A.Ft * (A.F * B)) + reg * B;
+  Matrix AB;
+  A.F_mul_B(AB, B);
+  A.Ft_mul_B(out, AB);
+  out.noalias() += reg * B;
+}
+
+inline void AtA_mul_B(Matrix& out, const BinarySparseSideInfo& A, double reg, const Matrix& B) {
+  Matrix AB;
+  A.F_mul_B(AB, B);
+  A.Ft_mul_B(out, AB);
+  out.noalias() += reg * B;
+}
+
+// single precision product, used by the inner iterations of the mixed-precision solver;
+// a template so it does not redefine the overload below when float_type is float
+template<typename M>
+inline typename std::enable_if<std::is_same<M, MatrixF>::value && !std::is_same<M, Matrix>::value>::type
+AtA_mul_B(M& out, const MixedSparseSideInfo& A, double reg, const M& B) {
+  out.noalias() = (A.Ft * (A.F * B)) + (float)reg * B;
+}
+
+// same product in float_type, for the residual of the mixed-precision solver
+inline void AtA_mul_B(Matrix& out, const MixedSparseSideInfo& A, double reg, const Matrix& B) {
+  Matrix AB;
+  A.F_mul_B(AB, B);
+  A.Ft_mul_B(out, AB);
+  out.noalias() += reg * B;
 }
 
 //
@@ -101,7 +132,10 @@ inline void AtA_mul_B(Matrix& out, const SparseSideInfo& A, double reg, const Ma
 //   X = n x m matrix
 //   B = n x m matrix
 //
-int solve_blockcg_1block(Matrix & X, const SparseSideInfo& K, double reg, Matrix & B, double tol, bool throw_on_cholesky_error) {
+template<typename SideInfo, typename M>
+int solve_blockcg_1block(M & X, const SideInfo& K, double reg, M & B, double tol, bool throw_on_cholesky_error) {
+  typedef Eigen::Matrix<typename M::Scalar, 1, Eigen::Dynamic, Eigen::RowMajor> V;
+
   // initialize
   const int nfeat = B.rows();
   const int nrhs  = B.cols();
@@ -109,7 +143,7 @@ int solve_blockcg_1block(Matrix & X, const SparseSideInfo& K, double reg, Matrix
 
   if (nfeat != K.cols()) {THROWERROR("B.rows() must equal K.cols()");}
 
-  Vector norms(nrhs), inorms(nrhs); 
+  V norms(nrhs), inorms(nrhs); 
   norms.setZero();
   inorms.setZero();
   #pragma omp parallel for schedule(static)
@@ -123,9 +157,8 @@ int solve_blockcg_1block(Matrix & X, const SparseSideInfo& K, double reg, Matrix
     norms(rhs)  = std::sqrt(sumsq);
     inorms(rhs) = 1.0 / norms(rhs);
   }
-  Matrix R(nfeat, nrhs);
-  Matrix P(nfeat, nrhs);
-  Matrix Ptmp(nfeat, nrhs);
+  M R(nfeat, nrhs);
+  M P(nfeat, nrhs);
   X.setZero();
   // normalize R and P:
   #pragma omp parallel for schedule(static) collapse(2)
@@ -137,13 +170,13 @@ int solve_blockcg_1block(Matrix & X, const SparseSideInfo& K, double reg, Matrix
       P(feat, rhs) = R(feat, rhs);
     }
   }
-  Matrix* RtR = new Matrix(nrhs, nrhs);
-  Matrix* RtR2 = new Matrix(nrhs, nrhs);
+  M* RtR = new M(nrhs, nrhs);
+  M* RtR2 = new M(nrhs, nrhs);
 
-  Matrix   KP(nfeat, nrhs);
-  Matrix KPtP(nrhs, nrhs);
-  Matrix A;
-  Matrix Psi;
+  M   KP(nfeat, nrhs);
+  M KPtP(nrhs, nrhs);
+  M A;
+  M Psi;
 
   //A_mul_At_combo(*RtR, R);
   *RtR = R.transpose() * R;
@@ -184,7 +217,7 @@ int solve_blockcg_1block(Matrix & X, const SparseSideInfo& K, double reg, Matrix
     *RtR2 = R.transpose() * R;
     makeSymmetric(*RtR2);
 
-    Vector d = RtR2->diagonal();
+    V d = RtR2->diagonal();
     // std::cout << "[ iter " << iter << "] " << std::scientific << d.transpose() << " (max: " << d.maxCoeff() << " > " << tolsq << ")" << std::endl;
     //std::cout << iter << ":" << std::scientific << d.transpose() << std::endl;
     if ( (d.array() < tolsq).all()) {
@@ -204,7 +237,7 @@ int solve_blockcg_1block(Matrix & X, const SparseSideInfo& K, double reg, Matrix
     {
       int row = block * 64;
       int brows = std::min(64, nfeat - row);
-      Matrix xtmp(brows, nrhs);
+      M xtmp(brows, nrhs);
       xtmp = P.block(row, 0, brows, nrhs) * Psi;
       P.block(row, 0, brows, nrhs) = R.block(row, 0, brows, nrhs) + xtmp;
     }
@@ -220,7 +253,7 @@ int solve_blockcg_1block(Matrix & X, const SparseSideInfo& K, double reg, Matrix
   
   if (iter == 1000)
   {
-    Vector d = RtR2->diagonal().cwiseSqrt();
+    V d = RtR2->diagonal().cwiseSqrt();
     std::cerr << "warning: block_cg: could not find a solution in 1000 iterations; residual: ["
               << d.transpose() << " ].all() > " << tol << std::endl;
   }
@@ -242,12 +275,13 @@ int solve_blockcg_1block(Matrix & X, const SparseSideInfo& K, double reg, Matrix
 
 
 /** good values for solve_blockcg are blocksize=32 an excess=8 */
-int solve_blockcg(Matrix & X, const SparseSideInfo& K, double reg, Matrix & B, double tol, const int blocksize, const int excess, bool throw_on_cholesky_error) {
+template<typename SideInfo, typename M>
+int solve_blockcg(M & X, const SideInfo& K, double reg, M & B, double tol, const int blocksize, const int excess, bool throw_on_cholesky_error) {
   if (B.cols() <= excess + blocksize) {
     return solve_blockcg_1block(X, K, reg, B, tol, throw_on_cholesky_error);
   }
   // split B into blocks of size <blocksize> (+ excess if needed)
-  Matrix Xblock, Bblock;
+  M Xblock, Bblock;
   int max_iter = 0;
   for (int i = 0; i < B.cols(); i += blocksize) {
     int ncols = blocksize;
@@ -266,6 +300,49 @@ int solve_blockcg(Matrix & X, const SparseSideInfo& K, double reg, Matrix & B, d
   return max_iter;
 }
 
+// Mixed precision: the block-CG runs in float on the residual,
+// the correction is accumulated in X and the residual is recomputed
+// with double accumulation until ||R_j|| <= tol * ||B_j|| for every column.
+int solve_blockcg(Matrix & X, const MixedSparseSideInfo& K, double reg, Matrix & B, double tol, const int blocksize, const int excess, bool throw_on_cholesky_error)
+{
+  // float cannot resolve much below this relative residual
+  const double inner_tol = std::max(tol, 1e-4);
+  const int max_refine = 10;
+
+  const int nfeat = B.rows();
+  const int nrhs  = B.cols();
+  if (nfeat != K.cols()) {THROWERROR("B.rows() must equal K.cols()");}
+
+  Vector bnorms(nrhs);
+  for (int rhs = 0; rhs < nrhs; rhs++)
+    bnorms(rhs) = B.col(rhs).norm();
+
+  X.setZero(nfeat, nrhs);
+  Matrix R = B;
+  Matrix KX;
+  MatrixF Rf, Xf(nfeat, nrhs);
+
+  int total_iter = 0;
+  for (int refine = 0; refine < max_refine; refine++)
+  {
+    Rf = R.cast<float>();
+    // the float template, not this overload when float_type is float
+    total_iter += solve_blockcg<MixedSparseSideInfo, MatrixF>(Xf, K, reg, Rf, inner_tol, blocksize, excess, throw_on_cholesky_error);
+    X += Xf.cast<float_type>();
+
+    // R = B - (K'K + reg * I) * X
+    AtA_mul_B(KX, K, reg, X);
+    R = B - KX;
+
+    bool converged = true;
+    for (int rhs = 0; rhs < nrhs && converged; rhs++)
+      converged = R.col(rhs).norm() <= tol * bnorms(rhs);
+    if (converged) break;
+  }
+
+  return total_iter;
+}
+
 int solve_blockcg_eigen(Matrix & X, const SparseSideInfo& K, double reg, Matrix & B, double tol, bool throw_on_cholesky_error)
 {
    COUNTER("eigen_cg");
@@ -277,4 +354,12 @@ int solve_blockcg_eigen(Matrix & X, const SparseSideInfo& K, double reg, Matrix
    return cg.iterations();
 }
 
+template int solve_blockcg_1block(Matrix &, const SparseSideInfo &, double, Matrix &, double, bool);
+template int solve_blockcg_1block(Matrix &, const BinarySparseSideInfo &, double, Matrix &, double, bool);
+template int solve_blockcg_1block(MatrixF &, const MixedSparseSideInfo &, double, MatrixF &, double, bool);
+
+template int solve_blockcg(Matrix &, const SparseSideInfo &, double, Matrix &, double, const int, const int, bool);
+template int solve_blockcg(Matrix &, const BinarySparseSideInfo &, double, Matrix &, double, const int, const int, bool);
+template int solve_blockcg(MatrixF &, const MixedSparseSideInfo &, double, MatrixF &, double, const int, const int, bool);
+
 }}
\ No newline at end of file
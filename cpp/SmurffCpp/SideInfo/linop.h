@@ -1,6 +1,5 @@
 #pragma once
 
-#include <SmurffCpp/Types.h>
 #include <SmurffCpp/Types.h>
 #include <Eigen/IterativeLinearSolvers>
 
@@ -9,6 +8,8 @@
 #include <SmurffCpp/Utils/counters.h>
 
 #include <SmurffCpp/SideInfo/SparseSideInfo.h>
+#include <SmurffCpp/SideInfo/BinarySparseSideInfo.h>
+#include <SmurffCpp/SideInfo/MixedSparseSideInfo.h>
 
 namespace smurff {
 namespace linop {
@@ -21,10 +22,18 @@ namespace linop {
 //   X = n x m matrix
 //   B = n x m matrix
 //
-int solve_blockcg_1block(Matrix & X, const SparseSideInfo& K, double reg, Matrix & B, double tol, bool throw_on_cholesky_error = false);
+//   SideInfo is SparseSideInfo or BinarySparseSideInfo (M = Matrix)
+//   or MixedSparseSideInfo (M = MatrixF)
+//
+template<typename SideInfo, typename M>
+int solve_blockcg_1block(M & X, const SideInfo& K, double reg, M & B, double tol, bool throw_on_cholesky_error = false);
 
 /** good values for solve_blockcg are blocksize=32 an excess=8 */
-int solve_blockcg(Matrix & X, const SparseSideInfo& K, double reg, Matrix & B, double tol, const int blocksize, const int excess, bool throw_on_cholesky_error = false);
+template<typename SideInfo, typename M>
+int solve_blockcg(M & X, const SideInfo& K, double reg, M & B, double tol, const int blocksize, const int excess, bool throw_on_cholesky_error = false);
+
+// float block-CG with iterative refinement in float_type
+int solve_blockcg(Matrix & X, const MixedSparseSideInfo& K, double reg, Matrix & B, double tol, const int blocksize, const int excess, bool throw_on_cholesky_error = false);
 
 int solve_blockcg_eigen(Matrix & X, const SparseSideInfo& K, double reg, Matrix & B, double tol, bool throw_on_cholesky_error = false);
 
@@ -16,4 +16,8 @@ namespace smurff {
    typedef Eigen::Array<float_type, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Array2D;
    typedef Eigen::Array<float_type, 1, Eigen::Dynamic, Eigen::RowMajor> Array1D;
    typedef Eigen::SparseMatrix<float_type, Eigen::RowMajor> SparseMatrix;
+
+   // single precision storage, for mixed-precision kernels
+   typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> MatrixF;
+   typedef Eigen::SparseMatrix<float, Eigen::RowMajor> SparseMatrixF;
 };
@@ -0,0 +1,94 @@
+#include "BackgroundWriter.h"
+
+#include <iostream>
+
+namespace smurff {
+
+BackgroundWriter::BackgroundWriter(int capacity)
+   : m_capacity(capacity)
+{
+   m_thread = std::thread(&BackgroundWriter::run, this);
+}
+
+BackgroundWriter::~BackgroundWriter()
+{
+   try
+   {
+      flush();
+   }
+   catch (const std::exception &e)
+   {
+      std::cerr << "Error in background writer: " << e.what() << std::endl;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+   }
+   m_cv.notify_all();
+   m_thread.join();
+}
+
+void BackgroundWriter::push(Job job)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_cv.wait(lock, [this] { return (int)m_queue.size() < m_capacity || m_error; });
+   rethrow();
+
+   m_queue.push_back(std::move(job));
+   lock.unlock();
+   m_cv.notify_all();
+}
+
+void BackgroundWriter::flush()
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_cv.wait(lock, [this] { return (m_queue.empty() && !m_busy) || m_error; });
+   rethrow();
+}
+
+// called with m_mutex held
+void BackgroundWriter::rethrow()
+{
+   if (m_error)
+   {
+      std::exception_ptr e = m_error;
+      m_error = nullptr;
+      m_queue.clear();
+      std::rethrow_exception(e);
+   }
+}
+
+void BackgroundWriter::run()
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+   while (true)
+   {
+      m_cv.wait(lock, [this] { return !m_queue.empty() || m_stop; });
+      if (m_queue.empty())
+         return; // stopped
+
+      Job job = std::move(m_queue.front());
+      m_queue.pop_front();
+      m_busy = true;
+      lock.unlock();
+      m_cv.notify_all(); // room in the queue
+
+      try
+      {
+         job();
+      }
+      catch (...)
+      {
+         lock.lock();
+         m_error = std::current_exception();
+         lock.unlock();
+      }
+
+      lock.lock();
+      m_busy = false;
+      m_cv.notify_all();
+   }
+}
+
+} // end namespace smurff
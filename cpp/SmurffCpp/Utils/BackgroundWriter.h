@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace smurff {
+
+// Runs jobs (typically writing a snapshot to disk) on a single background
+// thread, in the order they were pushed.
+//
+// At most `capacity` jobs wait in the queue: push() blocks when the writer
+// falls behind, so at most capacity + 1 snapshots are alive at any time.
+// An exception thrown by a job is rethrown by the next push() or flush().
+class BackgroundWriter
+{
+public:
+   typedef std::function<void()> Job;
+
+   BackgroundWriter(int capacity = 2);
+   ~BackgroundWriter();
+
+   BackgroundWriter(const BackgroundWriter &) = delete;
+   BackgroundWriter &operator=(const BackgroundWriter &) = delete;
+
+   // enqueue a job, blocks while the queue is full
+   void push(Job job);
+
+   // wait until all pushed jobs are done
+   void flush();
+
+private:
+   void run();
+   void rethrow();
+
+   const int m_capacity;
+
+   std::mutex m_mutex;
+   std::condition_variable m_cv;
+   std::deque<Job> m_queue;
+   bool m_busy = false;
+   bool m_stop = false;
+   std::exception_ptr m_error;
+
+   std::thread m_thread;
+};
+
+} // end namespace smurff
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <iostream>
+#include <numeric>
 
 #include <SmurffCpp/Utils/HDF5Group.h>
 
@@ -52,6 +54,72 @@ void HDF5Group::read(const std::string& section, const std::string& tag, Matrix
    }
 }
 
+void HDF5Group::read(const std::string& section, const std::string& tag, Matrix &X, std::size_t first_row, std::size_t num_rows) const
+{
+   static_assert(Matrix::IsRowMajor, "row range reads need a row-major Matrix");
+
+   auto dataset = m_group.getGroup(section).getDataSet(tag);
+   std::vector<size_t> dims = dataset.getDimensions();
+   THROWERROR_ASSERT(first_row + num_rows <= dims[0]);
+
+   // only the chunks holding these rows are read (and decompressed)
+   X.resize(num_rows, dims[1]);
+   if (X.size())
+      dataset.select({first_row, 0}, {num_rows, dims[1]}).read(X.data());
+}
+
+void HDF5Group::read(const std::string& section, const std::string& tag, Matrix &X, const std::vector<std::size_t> &rows) const
+{
+   auto dataset = m_group.getGroup(section).getDataSet(tag);
+   std::vector<size_t> dims = dataset.getDimensions();
+
+   std::vector<std::size_t> order(rows.size());
+   std::iota(order.begin(), order.end(), 0);
+   std::sort(order.begin(), order.end(), [&rows](std::size_t a, std::size_t b) { return rows[a] < rows[b]; });
+
+   X.resize(rows.size(), dims[1]);
+   if (X.size() == 0)
+      return;
+   THROWERROR_ASSERT(rows[order.back()] < dims[0]);
+
+   // the union of one hyperslab per run of consecutive rows, read at once:
+   // the distinct rows arrive in file order
+   hid_t file_space = H5Dget_space(dataset.getId());
+   herr_t status = 0;
+   hsize_t num_distinct = 0;
+   for (std::size_t begin = 0, end; begin < order.size(); begin = end)
+   {
+      for (end = begin + 1; end < order.size() && rows[order[end]] <= rows[order[end - 1]] + 1; ++end)
+         ;
+
+      const hsize_t offset[2] = {rows[order[begin]], 0};
+      const hsize_t count[2] = {rows[order[end - 1]] - rows[order[begin]] + 1, dims[1]};
+      status |= H5Sselect_hyperslab(file_space, begin ? H5S_SELECT_OR : H5S_SELECT_SET, offset, nullptr, count, nullptr);
+      num_distinct += count[0];
+   }
+
+   Matrix distinct(num_distinct, dims[1]);
+   const hsize_t mem_dims[2] = {num_distinct, dims[1]};
+   hid_t mem_space = H5Screate_simple(2, mem_dims, nullptr);
+   if (status >= 0)
+      status = H5Dread(dataset.getId(), h5::AtomicType<Matrix::Scalar>().getId(), mem_space, file_space, H5P_DEFAULT, distinct.data());
+   H5Sclose(mem_space);
+   H5Sclose(file_space);
+   THROWERROR_ASSERT_MSG(status >= 0, "Error reading rows of " + tag);
+
+   for (std::size_t k = 0, d = 0; k < order.size(); ++k)
+   {
+      if (k > 0 && rows[order[k]] != rows[order[k - 1]])
+         ++d;
+      X.row(order[k]) = distinct.row(d);
+   }
+}
+
+std::vector<std::size_t> HDF5Group::getDimensions(const std::string& section, const std::string& tag) const
+{
+   return m_group.getGroup(section).getDataSet(tag).getDimensions();
+}
+
 void HDF5Group::read(const std::string& section, const std::string& tag, Vector &X) const
 {
    auto dataset = m_group.getGroup(section).getDataSet(tag);
@@ -99,31 +167,122 @@ void HDF5Group::read(const std::string& section, const std::string& tag, SparseT
    THROWERROR_NOTIMPL();
 }
 
-void HDF5Group::write(const std::string& section, const std::string& tag, const Vector &V)
+// IEEE 754 half precision, HDF5 converts from and to double on write and read
+struct Float16Type : public h5::DataType
 {
-   write(section, tag, Matrix(V));
+   Float16Type()
+   {
+      _hid = H5Tcopy(H5T_IEEE_F32LE);
+      H5Tset_fields(_hid, 15, 10, 5, 0, 10);
+      H5Tset_precision(_hid, 16);
+      H5Tset_ebias(_hid, 15);
+      H5Tset_size(_hid, 2);
+   }
+};
+
+// chunks of about this size when chunk_rows is not set
+static const std::size_t TARGET_CHUNK_BYTES = 1 << 20;
+
+h5::DataSetCreateProps HDF5Group::createProps(const std::vector<std::size_t> &dims, std::size_t row_bytes) const
+{
+   h5::DataSetCreateProps props;
+
+   if (m_options.chunk_rows <= 0 && m_options.deflate <= 0)
+      return props; // contiguous
+
+   // HDF5 cannot chunk an empty dataset
+   for (auto d : dims)
+      if (d == 0)
+         return props;
+
+   std::size_t rows = m_options.chunk_rows > 0 ? m_options.chunk_rows : std::max<std::size_t>(1, TARGET_CHUNK_BYTES / row_bytes);
+   std::vector<hsize_t> chunk(dims.begin(), dims.end());
+   chunk[0] = std::min<std::size_t>(rows, dims[0]);
+   props.add(h5::Chunking(chunk));
+
+   if (m_options.deflate > 0)
+   {
+      props.add(h5::Shuffle());
+      props.add(h5::Deflate(m_options.deflate));
+   }
+
+   return props;
 }
 
-void HDF5Group::write(const std::string& section, const std::string& tag, const Matrix &M)
+template <typename T>
+h5::DataSet HDF5Group::createDataSet(h5::Group &group, const std::string &tag, std::size_t size)
+{
+   return group.createDataSet<T>(tag, h5::DataSpace(size), createProps({size}, sizeof(T)));
+}
+
+void HDF5Group::writeDense(const std::string& section, const std::string& tag,
+                           const Eigen::Ref<const RowMajorMatrix, 0, Eigen::InnerStride<1>> &M, const h5::DataType &type)
 {
    if (!m_group.exist(section))
       m_group.createGroup(section);
 
    h5::Group group = m_group.getGroup(section);
-   h5::DataSet dataset = group.createDataSet<Matrix::Scalar>(tag, h5::DataSpace({static_cast<size_t>(M.rows()),  static_cast<size_t>(M.cols())}));
+   std::vector<std::size_t> dims{static_cast<size_t>(M.rows()), static_cast<size_t>(M.cols())};
+   h5::DataSet dataset = group.createDataSet(tag, h5::DataSpace(dims), type, createProps(dims, M.cols() * sizeof(Matrix::Scalar)));
 
-   Eigen::Ref<
-        const Eigen::Matrix<
-            Matrix::Scalar,
-            Matrix::RowsAtCompileTime,
-            Matrix::ColsAtCompileTime,
-            Matrix::ColsAtCompileTime==1?Eigen::ColMajor:Eigen::RowMajor,
-            Matrix::MaxRowsAtCompileTime,
-            Matrix::MaxColsAtCompileTime>,
-        0,
-        Eigen::InnerStride<1>> row_major(M);
+   // straight from the Eigen buffer, HDF5 converts if type is not Matrix::Scalar
+   if (M.size())
+      dataset.write_raw(M.data());
+}
+
+void HDF5Group::createDense(const std::string& section, const std::string& tag, std::size_t rows, std::size_t cols)
+{
+   h5::Group group = addGroup(section);
+   std::vector<std::size_t> dims{rows, cols};
+   group.createDataSet(tag, h5::DataSpace(dims), h5::AtomicType<Matrix::Scalar>(), createProps(dims, cols * sizeof(Matrix::Scalar)));
+}
+
+void HDF5Group::writeRows(const std::string& section, const std::string& tag, std::size_t first_row, const Matrix &M)
+{
+   static_assert(Matrix::IsRowMajor, "row range writes need a row-major Matrix");
+
+   auto dataset = m_group.getGroup(section).getDataSet(tag);
+   std::vector<size_t> dims = dataset.getDimensions();
+   THROWERROR_ASSERT(first_row + M.rows() <= dims[0] && (std::size_t)M.cols() == dims[1]);
+
+   if (M.size())
+      dataset.select({first_row, 0}, {(std::size_t)M.rows(), dims[1]}).write(M.data());
+}
 
-    dataset.write_raw(row_major.data());
+void HDF5Group::write(const std::string& section, const std::string& tag, const Vector &V)
+{
+   writeDense(section, tag, V, h5::AtomicType<Matrix::Scalar>());
+}
+
+void HDF5Group::write(const std::string& section, const std::string& tag, const Matrix &M)
+{
+   writeDense(section, tag, M, h5::AtomicType<Matrix::Scalar>());
+}
+
+void HDF5Group::writeSample(const std::string& section, const std::string& tag, const Matrix &M)
+{
+   writeQuantized(section, tag, M, m_options.sample_bits);
+}
+
+void HDF5Group::writeQuantized(const std::string& section, const std::string& tag, const Matrix &M, int bits)
+{
+   switch (bits)
+   {
+      case 0:
+         writeDense(section, tag, M, h5::AtomicType<Matrix::Scalar>());
+         break;
+      case 32:
+         writeDense(section, tag, M, h5::AtomicType<float>());
+         break;
+      case 16:
+         writeDense(section, tag, M, Float16Type());
+         break;
+      case 8:
+         writeDense(section, tag, M, h5::AtomicType<signed char>());
+         break;
+      default:
+         THROWERROR("Unsupported number of bits: " + std::to_string(bits));
+   }
 }
 
 void HDF5Group::write(const std::string& section, const std::string& tag, const SparseMatrix &X)
@@ -137,13 +296,13 @@ void HDF5Group::write(const std::string& section, const std::string& tag, const
    std::vector<Eigen::Index> shape{X.rows(), X.cols()};
    sparse_group.createAttribute<Eigen::Index>("h5sparse_shape", h5::DataSpace::From(shape)).write(shape);
 
-   auto data = sparse_group.createDataSet<SparseMatrix::value_type>("data", h5::DataSpace(X.nonZeros()));
+   auto data = createDataSet<SparseMatrix::value_type>(sparse_group, "data", X.nonZeros());
    data.write(X.valuePtr());
 
-   auto indptr = sparse_group.createDataSet<SparseMatrix::Index>("indptr", h5::DataSpace(X.outerSize() + 1));
+   auto indptr = createDataSet<SparseMatrix::Index>(sparse_group, "indptr", X.outerSize() + 1);
    indptr.write(X.outerIndexPtr());
 
-   auto indices = sparse_group.createDataSet<SparseMatrix::Index>("indices", h5::DataSpace(X.nonZeros()));
+   auto indices = createDataSet<SparseMatrix::Index>(sparse_group, "indices", X.nonZeros());
    indices.write(X.innerIndexPtr());
 }
 
@@ -163,12 +322,12 @@ void HDF5Group::write(const std::string& section, const std::string& tag, const
    const auto &shape = X.getDims();
    sparse_group.createAttribute<SparseTensor::dims_type>("h5sparse_shape", h5::DataSpace::From(shape)).write(shape);
 
-   auto data = sparse_group.createDataSet<SparseTensor::value_type>("data", h5::DataSpace(X.getNNZ()));
+   auto data = createDataSet<SparseTensor::value_type>(sparse_group, "data", X.getNNZ());
    data.write(X.getValues().data());
 
    for(size_t i = 0; i < X.getNModes(); ++i)
    {
-      auto indices = sparse_group.createDataSet<SparseTensor::index_type>("indices_" + std::to_string(i), h5::DataSpace(X.getNNZ()));
+      auto indices = createDataSet<SparseTensor::index_type>(sparse_group, "indices_" + std::to_string(i), X.getNNZ());
       indices.write(X.getColumn(i).data());
    }
 }
@@ -14,10 +14,22 @@
 namespace h5 = HighFive;
 
 namespace smurff {
+   // layout of the datasets written by an HDF5Group
+   struct HDF5StorageOptions
+   {
+      int chunk_rows = 0;  // rows per chunk, 0 = about 1MB per chunk
+      int deflate = 0;     // gzip level 1-9 (after byte shuffle), 0 = contiguous, uncompressed
+      int sample_bits = 0; // store samples as 32 or 16 bit floats (lossy), 0 = full precision
+   };
+
    class HDF5Group
    {
+   public:
+      typedef HDF5StorageOptions StorageOptions;
+
    protected:
       h5::Group m_group;
+      StorageOptions m_options;
       h5::Group getGroup(const std::string &) const;
       h5::Group addGroup(const std::string &);
 
@@ -42,7 +54,8 @@ namespace smurff {
       }
 
    public:
-      HDF5Group(h5::Group group) : m_group(group) {}
+      HDF5Group(h5::Group group, const StorageOptions &options = StorageOptions())
+         : m_group(group), m_options(options) {}
 
       virtual ~HDF5Group() {}
 
@@ -69,6 +82,12 @@ namespace smurff {
 
       void read(const std::string &section, const std::string& tag, Vector &) const;
       void read(const std::string &section, const std::string& tag, Matrix &) const;
+      // rows [first_row, first_row + num_rows) only
+      void read(const std::string &section, const std::string& tag, Matrix &, std::size_t first_row, std::size_t num_rows) const;
+      // row i of the matrix is row rows[i] of the dataset
+      void read(const std::string &section, const std::string& tag, Matrix &, const std::vector<std::size_t> &rows) const;
+      // rows, cols without reading the data
+      std::vector<std::size_t> getDimensions(const std::string &section, const std::string& tag) const;
       void read(const std::string &section, const std::string& tag, SparseMatrix &) const;
       void read(const std::string &section, const std::string& tag, DenseTensor &) const;
       void read(const std::string &section, const std::string& tag, SparseTensor &) const;
@@ -96,5 +115,33 @@ namespace smurff {
       void write(const std::string &section, const std::string& tag, const SparseMatrix &);
       void write(const std::string &section, const std::string& tag, const DenseTensor &);
       void write(const std::string &section, const std::string& tag, const SparseTensor &);
+
+      // a rows x cols matrix, written a block of rows at a time by writeRows
+      void createDense(const std::string &section, const std::string& tag, std::size_t rows, std::size_t cols);
+      void writeRows(const std::string &section, const std::string& tag, std::size_t first_row, const Matrix &);
+
+      // like write(Matrix), with the reduced precision of m_options.sample_bits
+      void writeSample(const std::string &section, const std::string& tag, const Matrix &);
+
+      // like write(Matrix), stored as 32 or 16 bit floats or as 8 bit integers
+      // (the values of M must be integers in [-128, 127] then), 0 = full precision
+      void writeQuantized(const std::string &section, const std::string& tag, const Matrix &, int bits);
+
+   private:
+      typedef Eigen::Matrix<
+            Matrix::Scalar,
+            Matrix::RowsAtCompileTime,
+            Matrix::ColsAtCompileTime,
+            Matrix::ColsAtCompileTime==1?Eigen::ColMajor:Eigen::RowMajor,
+            Matrix::MaxRowsAtCompileTime,
+            Matrix::MaxColsAtCompileTime> RowMajorMatrix;
+
+      void writeDense(const std::string &section, const std::string& tag,
+                      const Eigen::Ref<const RowMajorMatrix, 0, Eigen::InnerStride<1>> &, const h5::DataType &);
+
+      template <typename T>
+      h5::DataSet createDataSet(h5::Group &group, const std::string &tag, std::size_t size);
+
+      h5::DataSetCreateProps createProps(const std::vector<std::size_t> &dims, std::size_t row_bytes) const;
    };
 }
@@ -1,5 +1,6 @@
 #include "MatrixUtils.h"
 
+#include <cmath>
 #include <numeric>
 #include <set>
 #include <vector>
@@ -79,5 +80,40 @@ bool matrix_utils::equals_vector(const Vector& v1, const Vector& v2, double epsi
    return equals(v1, v2, epsilon);
 }
 
+void matrix_utils::chol_rank1_update(Eigen::Ref<Matrix> R, Eigen::Ref<Vector> x)
+{
+   const int K = R.rows();
+   for (int k = 0; k < K; ++k)
+   {
+      const double Rkk = R(k, k);
+      const double r = std::sqrt(Rkk * Rkk + x(k) * x(k));
+      const double c = r / Rkk;
+      const double s = x(k) / Rkk;
+      R(k, k) = r;
+
+      const int rs = K - k - 1;
+      if (rs > 0)
+      {
+         R.row(k).tail(rs) = (R.row(k).tail(rs) + s * x.tail(rs)) / c;
+         x.tail(rs) = c * x.tail(rs) - s * R.row(k).tail(rs);
+      }
+   }
+}
+
+void matrix_utils::pack_lower(const Matrix &A, float_type *packed)
+{
+   const int K = A.rows();
+   for (int a = 0; a < K; ++a)
+      for (int b = 0; b <= a; ++b)
+         *packed++ = A(a, b);
+}
+
+void matrix_utils::unpack_symmetric(const float_type *packed, Matrix &A)
+{
+   const int K = A.rows();
+   for (int a = 0; a < K; ++a)
+      for (int b = 0; b <= a; ++b)
+         A(a, b) = A(b, a) = *packed++;
+}
 
 } // end namespace
\ No newline at end of file
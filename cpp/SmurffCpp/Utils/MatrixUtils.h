@@ -68,4 +68,13 @@ namespace smurff { namespace matrix_utils {
 
    bool equals(const Matrix& m1, const Matrix& m2, double epsilon = std::numeric_limits<double>::epsilon());
    bool equals_vector(const Vector& v1, const Vector& v2, double epsilon = std::numeric_limits<double>::epsilon() * 100);
+
+   // R' * R += x' * x, with R upper triangular, in O(K^2) (x is overwritten)
+   void chol_rank1_update(Eigen::Ref<Matrix> R, Eigen::Ref<Vector> x);
+
+   // packed lower triangle of a symmetric K x K matrix, stored row by row:
+   // (0,0), (1,0), (1,1), (2,0), ... -- K * (K + 1) / 2 values
+   inline int packed_size(int K) { return K * (K + 1) / 2; }
+   void pack_lower(const Matrix &A, float_type *packed);
+   void unpack_symmetric(const float_type *packed, Matrix &A);
 }}
@@ -0,0 +1,120 @@
+#include "RowScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace smurff {
+
+// a row is heavy when it costs more than 1/HEAVY_SHARE of a thread's share
+static const int HEAVY_SHARE = 4;
+// splitting rows with fewer observations does not pay off
+static const int MIN_SPLIT_NNZ = 1000;
+// a chunk of light rows should take about this long ...
+static const double TARGET_CHUNK_SECS = 50e-6;
+// ... but each thread should get at least this many chunks
+static const int CHUNKS_PER_THREAD = 8;
+
+void RowScheduler::init(const std::vector<int> &nnz)
+{
+   m_nnz = nnz;
+   m_known = std::all_of(nnz.begin(), nnz.end(), [](int x) { return x >= 0; });
+
+   m_order.resize(nnz.size());
+   std::iota(m_order.begin(), m_order.end(), 0);
+   // a single thread gains nothing from reordering, keep the natural
+   // (reproducible) order then
+   if (m_known && threads::get_max_threads() > 1)
+   {
+      std::stable_sort(m_order.begin(), m_order.end(), [&nnz](int a, int b) { return nnz[a] > nnz[b]; });
+   }
+
+   m_stats.init();
+
+   // until the first sweep is measured, assume the cost is proportional to nnz
+   m_c0 = 0.0;
+   m_c1 = 1.0;
+   m_tuned = false;
+   plan();
+}
+
+void RowScheduler::tune(const Stats &s)
+{
+   if (s.n < 2)
+      return;
+
+   // least squares fit of t = c0 + c1 * nnz
+   double c0 = s.t / s.n;
+   double c1 = 0.0;
+   const double det = s.n * s.xx - s.x * s.x;
+   if (m_known && det > 0)
+   {
+      c1 = (s.n * s.xt - s.x * s.t) / det;
+      c0 = (s.t - c1 * s.x) / s.n;
+   }
+
+   if (c1 < 0)
+   {
+      c1 = 0.0;
+      c0 = s.t / s.n;
+   }
+   else if (c0 < 0)
+   {
+      c0 = 0.0;
+      c1 = s.xt / s.xx;
+   }
+
+   // smooth over sweeps, timings of a single sweep are noisy
+   if (m_tuned)
+   {
+      c0 = 0.5 * (m_c0 + c0);
+      c1 = 0.5 * (m_c1 + c1);
+   }
+
+   m_c0 = c0;
+   m_c1 = c1;
+   m_tuned = true;
+   plan();
+}
+
+void RowScheduler::plan()
+{
+   const int nthreads = threads::get_max_threads();
+   const int num_rows = m_order.size();
+
+   // heavy rows
+   m_split_nnz = m_known ? std::numeric_limits<int>::max() : -1;
+   m_num_heavy = 0;
+   if (m_known && nthreads > 1 && m_c1 > 0)
+   {
+      const double total_nnz = std::accumulate(m_nnz.begin(), m_nnz.end(), 0.0);
+      const double total = num_rows * m_c0 + total_nnz * m_c1;
+      const double limit = total / (nthreads * HEAVY_SHARE);
+      const double split = std::max<double>(std::ceil((limit - m_c0) / m_c1), MIN_SPLIT_NNZ);
+
+      if (split < std::numeric_limits<int>::max())
+         m_split_nnz = split;
+
+      while (m_num_heavy < num_rows && m_nnz[m_order[m_num_heavy]] >= m_split_nnz)
+         m_num_heavy++;
+   }
+
+   // chunk size of the light tail
+   m_chunk = 1;
+   const int num_light = num_rows - m_num_heavy;
+   if (m_tuned && num_light > 0)
+   {
+      double light_nnz = 0.0;
+      if (m_known)
+         for (int i = m_num_heavy; i < num_rows; ++i)
+            light_nnz += m_nnz[m_order[i]];
+
+      const double row_secs = m_c0 + m_c1 * light_nnz / num_light;
+      const int max_chunk = std::max(1, num_light / (nthreads * CHUNKS_PER_THREAD));
+      const double chunk = row_secs > 0 ? TARGET_CHUNK_SECS / row_secs : max_chunk;
+      m_chunk = std::max(1, (int)std::min<double>(chunk, max_chunk));
+   }
+}
+
+} // end namespace smurff
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "omp_util.h"
+#include "ThreadVector.hpp"
+
+namespace smurff {
+
+// Schedules the rows of one mode over the OpenMP team.
+//
+// Rows are presorted by their number of observations once. Heavy rows
+// (rows that alone would dominate a thread's share of the work) go first,
+// one task each, so that the data can split them further into sub-tasks.
+// The light tail follows, heaviest first, in dynamically scheduled chunks.
+//
+// The cost of a row is modelled as c0 + c1 * nnz. Both constants are
+// refitted from measured row times after every sweep and drive the
+// heavy-row threshold and the chunk size of the tail.
+class RowScheduler
+{
+public:
+   // nnz[n] = number of observations in row n, -1 if not known
+   void init(const std::vector<int> &nnz);
+
+   // rows with at least this many observations are heavy and should be split,
+   // -1 if the number of observations is not known
+   int split_nnz() const { return m_split_nnz; }
+   int chunk_size() const { return m_chunk; }
+
+   double c0() const { return m_c0; }
+   double c1() const { return m_c1; }
+
+   // calls f(n) once for every row
+   template <typename F>
+   void run(F f);
+
+private:
+   struct Stats
+   {
+      double n = 0, x = 0, xx = 0, t = 0, xt = 0;
+
+      void add(double nnz, double secs)
+      {
+         n += 1; x += nnz; xx += nnz * nnz; t += secs; xt += nnz * secs;
+      }
+
+      Stats &operator+=(const Stats &o)
+      {
+         n += o.n; x += o.x; xx += o.xx; t += o.t; xt += o.xt;
+         return *this;
+      }
+   };
+
+   void tune(const Stats &s);
+   void plan();
+
+   std::vector<int> m_order;     // rows, by decreasing nnz
+   std::vector<int> m_nnz;
+   int m_num_heavy = 0;          // m_order[0 .. m_num_heavy) are heavy
+   int m_split_nnz = -1;
+   int m_chunk = 1;
+   bool m_known = false;         // nnz per row is known
+
+   double m_c0 = 0.0;            // seconds per row
+   double m_c1 = 0.0;            // seconds per observation
+   bool m_tuned = false;
+
+   thread_vector<Stats> m_stats;
+};
+
+template <typename F>
+void RowScheduler::run(F f)
+{
+   typedef std::chrono::steady_clock clock;
+
+   const int num_rows = m_order.size();
+   const int num_heavy = m_num_heavy;
+   const int chunk = m_chunk;
+
+   #pragma omp parallel
+   {
+      #pragma omp single
+      for (int i = 0; i < num_heavy; ++i)
+      {
+         const int n = m_order[i];
+         #pragma omp task firstprivate(n)
+         f(n);
+      }
+
+      auto &stats = m_stats.local();
+
+      #pragma omp for schedule(dynamic, chunk)
+      for (int i = num_heavy; i < num_rows; ++i)
+      {
+         const int n = m_order[i];
+         const auto start = clock::now();
+         f(n);
+         const std::chrono::duration<double> secs = clock::now() - start;
+         stats.add(m_known ? m_nnz[n] : 0, secs.count());
+      }
+   }
+
+   tune(m_stats.combine_and_reset());
+}
+
+} // end namespace smurff
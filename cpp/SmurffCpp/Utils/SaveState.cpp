@@ -45,8 +45,8 @@
 
 namespace smurff {
 
-SaveState::SaveState(h5::File file, std::int32_t isample, bool checkpoint, bool save_aggr)
-   : HDF5Group(file.createGroup(std::string(checkpoint ? CHECKPOINT_PREFIX : SAMPLE_PREFIX) + std::to_string(isample)))
+SaveState::SaveState(h5::File file, std::int32_t isample, bool checkpoint, bool save_aggr, const StorageOptions &options)
+   : HDF5Group(file.createGroup(std::string(checkpoint ? CHECKPOINT_PREFIX : SAMPLE_PREFIX) + std::to_string(isample)), options)
    , m_file(file) 
    , m_isample(isample)
    , m_checkpoint(checkpoint)
@@ -93,6 +93,21 @@ void SaveState::readModel(std::uint64_t index, Matrix &m) const
    read(LATENTS_SEC_TAG, LATENTS_PREFIX + std::to_string(index), m);
 }
 
+void SaveState::readModel(std::uint64_t index, Matrix &m, std::size_t first_row, std::size_t num_rows) const
+{
+   read(LATENTS_SEC_TAG, LATENTS_PREFIX + std::to_string(index), m, first_row, num_rows);
+}
+
+void SaveState::readModel(std::uint64_t index, Matrix &m, const std::vector<std::size_t> &rows) const
+{
+   read(LATENTS_SEC_TAG, LATENTS_PREFIX + std::to_string(index), m, rows);
+}
+
+std::vector<std::size_t> SaveState::getModelShape(std::uint64_t index) const
+{
+   return getDimensions(LATENTS_SEC_TAG, LATENTS_PREFIX + std::to_string(index));
+}
+
 std::string SaveState::getName() const
 {
    return std::string(isCheckpoint() ? CHECKPOINT_PREFIX : SAMPLE_PREFIX) + std::to_string(getIsample());
@@ -103,7 +118,7 @@ void SaveState::putModel(const std::vector<Matrix> &F)
    m_group.createAttribute(NUM_MODES_TAG, F.size());
    for (std::uint64_t m = 0; m < F.size(); ++m)
    {
-      write(LATENTS_SEC_TAG, LATENTS_PREFIX + std::to_string(m), F[m]);
+      writeSample(LATENTS_SEC_TAG, LATENTS_PREFIX + std::to_string(m), F[m]);
    }
 }
 
@@ -146,6 +161,11 @@ void SaveState::putAggr(std::uint64_t index, int num, const Matrix &sum, const M
    write(LATENTS_SEC_TAG, POST_DOT_PREFIX + std::to_string(index), dot);
 }
 
+bool SaveState::hasPostMuLambda(std::uint64_t index) const
+{
+   return hasDataSet(LATENTS_SEC_TAG, POST_MU_PREFIX + std::to_string(index));
+}
+
 void SaveState::readPostMuLambda(std::uint64_t index, Matrix &mu, Matrix &Lambda) const
 {
    read(LATENTS_SEC_TAG, POST_MU_PREFIX + std::to_string(index), mu);
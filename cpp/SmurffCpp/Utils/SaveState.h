@@ -27,7 +27,7 @@ namespace smurff {
 
    public:
       //this constructor should be used to create a step file on a first run of trainSession
-      SaveState(h5::File file, std::int32_t isample, bool checkpoint, bool final);
+      SaveState(h5::File file, std::int32_t isample, bool checkpoint, bool final, const StorageOptions &options = StorageOptions());
 
       //this constructor should be used to  open existing step file when previous trainSession is continued
       SaveState(h5::File file, h5::Group group);
@@ -37,10 +37,15 @@ namespace smurff {
    public:
       bool hasModel(std::uint64_t index) const;
       bool hasAggr(std::uint64_t index) const;
+      bool hasPostMuLambda(std::uint64_t index) const;
       bool hasPred() const;
 
 
       void readModel(std::uint64_t index, Matrix &) const;
+      void readModel(std::uint64_t index, Matrix &, std::size_t first_row, std::size_t num_rows) const;
+      void readModel(std::uint64_t index, Matrix &, const std::vector<std::size_t> &rows) const;
+      // rows, cols of the latent matrix, without reading it
+      std::vector<std::size_t> getModelShape(std::uint64_t index) const;
       void readMu(std::uint64_t index, Vector &) const;
       void readLinkMatrix(std::uint32_t index, Matrix &) const;
       void readAggr(std::uint64_t index, int &, Matrix &, Matrix &) const;
@@ -1,5 +1,6 @@
 #include "StateFile.h"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 
@@ -20,6 +21,8 @@ const std::string STATUS_TAG = "status";
 const std::string LAST_CHECKPOINT_TAG = "last_checkpoint";
 const std::string CHECKPOINT_PREFIX = "checkpoint_";
 const std::string SAMPLE_PREFIX = "sample_";
+const std::string SAMPLES_TAG = "samples";
+const hsize_t SAMPLE_INDEX_CHUNK = 256;
 
 StateFile::StateFile(std::string path, bool create)
    : m_path(path)
@@ -31,6 +34,11 @@ StateFile::StateFile(std::string path, bool create)
    }
 }
 
+void StateFile::setStorageOptions(const HDF5Group::StorageOptions &options)
+{
+   m_options = options;
+}
+
 std::string StateFile::getPath() const
 {
    return m_path;
@@ -55,7 +63,66 @@ SaveState StateFile::createSampleStep(std::int32_t isample, bool save_aggr)
 
 SaveState StateFile::createStep(std::int32_t isample, bool checkpoint, bool save_aggr)
 {
-   return SaveState(m_h5, isample, checkpoint, save_aggr);
+   // a checkpoint is resumed from, its latents are not rounded to sample_bits
+   HDF5Group::StorageOptions options = m_options;
+   if (checkpoint)
+      options.sample_bits = 0;
+
+   return SaveState(m_h5, isample, checkpoint, save_aggr, options);
+}
+
+void StateFile::indexSampleStep(std::int32_t isample)
+{
+   THROWERROR_ASSERT_MSG(hasSampleStep(isample), "No sample " + std::to_string(isample) + " in " + m_path);
+
+   h5::Group steps = m_h5.exist(STEPS_TAG) ? m_h5.getGroup(STEPS_TAG) : m_h5.createGroup(STEPS_TAG);
+   std::vector<int> numbers;
+   std::size_t offset = 0;
+
+   if (steps.exist(SAMPLES_TAG))
+   {
+      steps.getDataSet(SAMPLES_TAG).read(numbers);
+      auto pos = std::lower_bound(numbers.begin(), numbers.end(), isample);
+      if (pos != numbers.end() && *pos == isample)
+         return;
+
+      // usually the last one, out of order numbers shift the tail
+      offset = pos - numbers.begin();
+      numbers.insert(pos, isample);
+   }
+   else
+   {
+      // files without an index are scanned, the new step is among the groups
+      numbers = getSampleNumbers();
+
+      const hsize_t dims[1] = {0};
+      const hsize_t max_dims[1] = {H5S_UNLIMITED};
+      const hsize_t chunk[1] = {SAMPLE_INDEX_CHUNK};
+      hid_t space = H5Screate_simple(1, dims, max_dims);
+      hid_t props = H5Pcreate(H5P_DATASET_CREATE);
+      H5Pset_chunk(props, 1, chunk);
+      hid_t dataset = H5Dcreate2(steps.getId(), SAMPLES_TAG.c_str(), h5::AtomicType<int>().getId(), space, H5P_DEFAULT, props, H5P_DEFAULT);
+      H5Pclose(props);
+      H5Sclose(space);
+      THROWERROR_ASSERT_MSG(dataset >= 0, "Error creating the sample index in " + m_path);
+      H5Dclose(dataset);
+   }
+
+   // grow by one, write from offset on
+   h5::DataSet dataset = steps.getDataSet(SAMPLES_TAG);
+   const hsize_t size[1] = {numbers.size()};
+   const hsize_t start[1] = {offset};
+   const hsize_t count[1] = {numbers.size() - offset};
+   herr_t status = H5Dset_extent(dataset.getId(), size);
+   hid_t file_space = H5Dget_space(dataset.getId());
+   hid_t mem_space = H5Screate_simple(1, count, nullptr);
+   if (status >= 0)
+      status = H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, nullptr, count, nullptr);
+   if (status >= 0)
+      status = H5Dwrite(dataset.getId(), h5::AtomicType<int>().getId(), mem_space, file_space, H5P_DEFAULT, numbers.data() + offset);
+   H5Sclose(mem_space);
+   H5Sclose(file_space);
+   THROWERROR_ASSERT_MSG(status >= 0, "Error writing the sample index in " + m_path);
 }
 
 void StateFile::removeOldCheckpoints()
@@ -91,19 +158,45 @@ SaveState StateFile::openCheckpoint() const
    return SaveState(m_h5, group);
 }
 
-std::vector<SaveState> StateFile::openSampleSteps() const
+std::vector<int> StateFile::getSampleNumbers() const
 {
-   std::vector<std::string> h5_objects = m_h5.listObjectNames();
-   std::vector<SaveState> samples;
+   std::vector<int> numbers;
 
-   for (auto &name : h5_objects)
+   if (m_h5.exist(STEPS_TAG) && m_h5.getGroup(STEPS_TAG).exist(SAMPLES_TAG))
+   {
+      m_h5.getGroup(STEPS_TAG).getDataSet(SAMPLES_TAG).read(numbers);
+      return numbers;
+   }
+
+   // listed by name: "sample_10" comes before "sample_2"
+   for (auto &name : m_h5.listObjectNames())
    {
       if (startsWith(name, SAMPLE_PREFIX))
-      {
-         h5::Group group = m_h5.getGroup(name);
-         samples.push_back(SaveState(m_h5, group));
-      }
+         numbers.push_back(std::stoi(name.substr(SAMPLE_PREFIX.size())));
    }
+   std::sort(numbers.begin(), numbers.end());
+
+   return numbers;
+}
+
+bool StateFile::hasSampleStep(int isample) const
+{
+   return m_h5.exist(SAMPLE_PREFIX + std::to_string(isample));
+}
+
+SaveState StateFile::openSampleStep(int isample) const
+{
+   THROWERROR_ASSERT_MSG(hasSampleStep(isample), "No sample " + std::to_string(isample) + " in " + m_path);
+   h5::Group group = m_h5.getGroup(SAMPLE_PREFIX + std::to_string(isample));
+   return SaveState(m_h5, group);
+}
+
+std::vector<SaveState> StateFile::openSampleSteps() const
+{
+   std::vector<SaveState> samples;
+
+   for (int isample : getSampleNumbers())
+      samples.push_back(openSampleStep(isample));
 
    return samples;
 }
@@ -20,10 +20,14 @@ class StateFile
 private:
    std::string m_path;
    h5::File m_h5;
+   HDF5Group::StorageOptions m_options;
 
 public:
    StateFile(std::string path, bool create = false);
 
+   // layout of the steps created from now on
+   void setStorageOptions(const HDF5Group::StorageOptions &options);
+
 public:
    std::string getPath() const;
 
@@ -35,13 +39,24 @@ public:
    SaveState createSampleStep(std::int32_t isample, bool save_aggr);
    SaveState createStep(std::int32_t isample, bool checkpoint, bool save_aggr);
 
+   // adds a sample step to the index, once all its datasets are written
+   void indexSampleStep(std::int32_t isample);
+
 public:
    void removeOldCheckpoints();
 
 public:
    bool hasCheckpoint() const;
    SaveState openCheckpoint() const;
+
+   // numbers of the saved samples, in increasing order, from the index written
+   // with the samples (or from the group names for files without an index)
+   std::vector<int> getSampleNumbers() const;
+   bool hasSampleStep(int isample) const;
+
+   // the step of sample number isample, its datasets are read on demand
    SaveState openSampleStep(int isample) const;
+   // all sample steps, in increasing sample number
    std::vector<SaveState> openSampleSteps() const;
 };
 
@@ -4,12 +4,65 @@
 #include <numeric>
 #include <vector>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <type_traits>
+
+#include <Eigen/Core>
 
 #include "omp_util.h"
 
+// size of a cache line, per-thread values never share one
+#define THREAD_VECTOR_CACHE_LINE 64
+
+// allocates blocks aligned to a cache line
+// (std::allocator ignores over-aligned types before C++17)
 template <typename T>
+struct cache_aligned_allocator
+{
+    typedef T value_type;
+
+    cache_aligned_allocator() = default;
+    template <typename U>
+    cache_aligned_allocator(const cache_aligned_allocator<U> &) {}
+
+    T *allocate(std::size_t n)
+    {
+        // over-allocate, keep the original pointer right before the aligned block
+        const std::size_t align = THREAD_VECTOR_CACHE_LINE;
+        char *raw = static_cast<char *>(::operator new(n * sizeof(T) + align + sizeof(void *)));
+        std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void *) + align - 1) & ~(align - 1);
+        reinterpret_cast<void **>(aligned)[-1] = raw;
+        return reinterpret_cast<T *>(aligned);
+    }
+
+    void deallocate(T *p, std::size_t)
+    {
+        ::operator delete(reinterpret_cast<void **>(p)[-1]);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const cache_aligned_allocator<T> &, const cache_aligned_allocator<U> &) { return true; }
+template <typename T, typename U>
+bool operator!=(const cache_aligned_allocator<T> &, const cache_aligned_allocator<U> &) { return false; }
+
+// One value of T per OpenMP thread.
+//
+// Every value sits in its own cache-line aligned slot, so threads updating
+// their local() value do not invalidate each other's lines.
+template <typename T, typename Enable = void>
 class thread_vector
 {
+    struct alignas(THREAD_VECTOR_CACHE_LINE) Slot
+    {
+        T value;
+    };
+
+    typedef std::vector<Slot, cache_aligned_allocator<Slot>> Slots;
+
 public:
     thread_vector(const T &t = T())
     {
@@ -18,24 +71,31 @@ public:
     template <typename F>
     T combine(F f) const
     {
-        return std::accumulate(_m.begin(), _m.end(), _i, f);
+        T ret = _i;
+        for (const auto &s : _m)
+            ret = f(ret, s.value);
+        return ret;
     }
     T combine() const
     {
-        return std::accumulate(_m.begin(), _m.end(), _i, std::plus<T>());
+        T ret = _i;
+        for (const auto &s : _m)
+            ret += s.value;
+        return ret;
     }
 
     T &local()
     {
-        return _m.at(threads::get_thread_num());
+        assert(threads::get_thread_num() < (int)_m.size());
+        return _m[threads::get_thread_num()].value;
     }
     void reset()
     {
-        for (auto &t : _m)
-            t = _i;
+        for (auto &s : _m)
+            s.value = _i;
     }
     template <typename F>
-    T combine_and_reset(F f) const
+    T combine_and_reset(F f)
     {
         T ret = combine(f);
         reset();
@@ -43,10 +103,26 @@ public:
     }
     T combine_and_reset()
     {
-        T ret = combine();
-        reset();
+        T ret = _i;
+        combine_and_reset(ret);
         return ret;
     }
+    // out = init value + sum of all per-thread values
+    //
+    // Pairwise in-place reduction over the slots, then every slot is reset.
+    // Does not allocate when out and the slots already have the right size.
+    void combine_and_reset(T &out)
+    {
+        const std::size_t n = _m.size();
+        for (std::size_t stride = 1; stride < n; stride *= 2)
+            for (std::size_t i = 0; i + stride < n; i += 2 * stride)
+                _m[i].value += _m[i + stride].value;
+
+        out = _i;
+        if (n > 0)
+            out += _m[0].value;
+        reset();
+    }
     void init(const T &t = T())
     {
         _i = t;
@@ -56,11 +132,152 @@ public:
     void init(const std::vector<T> &v)
     {
         assert((int)v.size() == threads::get_max_threads());
-        _m.resize(threads::get_max_threads());
-        _m = v;
+        _m.resize(v.size());
+        for (std::size_t i = 0; i < v.size(); ++i)
+            _m[i].value = v[i];
+    }
+
+    int size() const
+    {
+        return _m.size();
     }
 
-    typedef typename std::vector<T>::const_iterator const_iterator;
+    // iterates over the per-thread values
+    class const_iterator
+    {
+    public:
+        const_iterator(typename Slots::const_iterator it) : _it(it) {}
+
+        const T &operator*() const { return _it->value; }
+        const T *operator->() const { return &_it->value; }
+        const_iterator &operator++() { ++_it; return *this; }
+        bool operator==(const const_iterator &o) const { return _it == o._it; }
+        bool operator!=(const const_iterator &o) const { return _it != o._it; }
+
+    private:
+        typename Slots::const_iterator _it;
+    };
+
+    const_iterator begin() const
+    {
+        return const_iterator(_m.begin());
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(_m.end());
+    }
+
+private:
+    Slots _m;
+    T _i;
+};
+
+// Eigen matrices and arrays keep their coefficients on the heap, out of reach
+// of the slot padding. Here the coefficients of all threads share one buffer,
+// every thread's block starting on a cache line of its own, and local() is a
+// Map into that buffer. All values have the shape of the init value.
+template <typename T>
+class thread_vector<T, typename std::enable_if<std::is_base_of<Eigen::PlainObjectBase<T>, T>::value>::type>
+{
+    typedef typename T::Scalar Scalar;
+    typedef std::vector<Scalar, cache_aligned_allocator<Scalar>> Buffer;
+
+public:
+    typedef Eigen::Map<T, Eigen::Aligned64> Local;
+    typedef typename std::vector<Local>::const_iterator const_iterator;
+
+    thread_vector(const T &t = T())
+    {
+        init(t);
+    }
+    // the maps point into the copied buffer
+    thread_vector(const thread_vector &o) : _buf(o._buf), _stride(o._stride), _i(o._i)
+    {
+        map(o._m.size());
+    }
+    thread_vector &operator=(const thread_vector &o)
+    {
+        _buf = o._buf;
+        _stride = o._stride;
+        _i = o._i;
+        map(o._m.size());
+        return *this;
+    }
+
+    template <typename F>
+    T combine(F f) const
+    {
+        T ret = _i;
+        for (const auto &s : _m)
+            ret = f(ret, s);
+        return ret;
+    }
+    T combine() const
+    {
+        T ret = _i;
+        for (const auto &s : _m)
+            ret += s;
+        return ret;
+    }
+
+    Local &local()
+    {
+        assert(threads::get_thread_num() < (int)_m.size());
+        return _m[threads::get_thread_num()];
+    }
+    void reset()
+    {
+        for (auto &s : _m)
+            s = _i;
+    }
+    template <typename F>
+    T combine_and_reset(F f)
+    {
+        T ret = combine(f);
+        reset();
+        return ret;
+    }
+    T combine_and_reset()
+    {
+        T ret = _i;
+        combine_and_reset(ret);
+        return ret;
+    }
+    // as thread_vector::combine_and_reset(T &)
+    void combine_and_reset(T &out)
+    {
+        const std::size_t n = _m.size();
+        for (std::size_t stride = 1; stride < n; stride *= 2)
+            for (std::size_t i = 0; i + stride < n; i += 2 * stride)
+                _m[i] += _m[i + stride];
+
+        out = _i;
+        if (n > 0)
+            out += _m[0];
+        reset();
+    }
+    void init(const T &t = T())
+    {
+        _i = t;
+        const std::size_t line = THREAD_VECTOR_CACHE_LINE / sizeof(Scalar);
+        _stride = (t.size() + line - 1) / line * line;
+        _buf.assign(threads::get_max_threads() * _stride, Scalar(0));
+        map(threads::get_max_threads());
+        reset();
+    }
+    void init(const std::vector<T> &v)
+    {
+        assert((int)v.size() == threads::get_max_threads());
+        init(v.empty() ? T() : v.front());
+        for (std::size_t i = 0; i < v.size(); ++i)
+            _m[i] = v[i];
+    }
+
+    int size() const
+    {
+        return _m.size();
+    }
 
     const_iterator begin() const
     {
@@ -73,6 +290,16 @@ public:
     }
 
 private:
-    std::vector<T> _m;
+    void map(std::size_t n)
+    {
+        _m.clear();
+        _m.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+            _m.emplace_back(_buf.data() + i * _stride, _i.rows(), _i.cols());
+    }
+
+    Buffer _buf;
+    std::size_t _stride = 0;
+    std::vector<Local> _m;
     T _i;
-};
\ No newline at end of file
+};
@@ -8,6 +8,7 @@
 #ifdef PROFILING
 
 #include <cmath>
+#include <list>
 #include <mutex>
 #include <iostream>
 #include <iomanip>
@@ -16,18 +17,34 @@
 #include <cmath>
 
 #include "counters.h"
-#include "SmurffCpp/Utils/omp_util.h"
 
-static thread_vector<Counter *> active_counters(0);
-thread_vector<TotalsCounter> perf_data;
+static thread_local Counter *active_counter = 0;
+
+// every thread adds its totals on first use, the list keeps them in place
+static std::mutex perf_data_mutex;
+static std::list<TotalsCounter> perf_data;
+static thread_local TotalsCounter *local_totals = 0;
+
+TotalsCounter &perf_data_local()
+{
+    if (!local_totals)
+    {
+        std::lock_guard<std::mutex> lock(perf_data_mutex);
+        perf_data.emplace_back();
+        local_totals = &perf_data.back();
+    }
+    return *local_totals;
+}
 
 void perf_data_init()
 {
-    active_counters.init();
-    perf_data.init();
+    std::lock_guard<std::mutex> lock(perf_data_mutex);
+    for(auto &p : perf_data)
+        p.clear();
 }
 
 void perf_data_print() {
+    std::lock_guard<std::mutex> lock(perf_data_mutex);
     int threadid = 0;
     for(auto &p : perf_data)
     {
@@ -38,8 +55,8 @@ void perf_data_print() {
 Counter::Counter(std::string name)
     : name(name), diff(0), count(1), total_counter(false)
 {
-    parent = active_counters.local();
-    active_counters.local() = this;
+    parent = active_counter;
+    active_counter = this;
 
     fullname = (parent) ? parent->fullname + "/" + name : name; 
 
@@ -57,8 +74,8 @@ Counter::~Counter() {
     stop = tick();
     diff = stop - start;
 
-    perf_data.local()[fullname] += *this;
-    active_counters.local() = parent;
+    perf_data_local()[fullname] += *this;
+    active_counter = parent;
 }
 
 void Counter::operator+=(const Counter &other) {
@@ -9,7 +9,6 @@
 
 #include <string>
 #include <map>
-#include <SmurffCpp/Utils/ThreadVector.hpp>
 
 #define COUNTER(name) Counter c(name)
 
@@ -47,9 +46,14 @@ struct TotalsCounter {
         Counter &operator[](const std::string &name) {
             return data[name];
         }
+
+        void clear() { data.clear(); }
 };
 
-extern thread_vector<TotalsCounter> perf_data;
+// Totals are kept per system thread, not per OpenMP thread number: the
+// background writer and evaluator run their own OpenMP teams next to the
+// sampler's, with the same thread numbers.
+TotalsCounter &perf_data_local();
 
 void perf_data_init();
 void perf_data_print();
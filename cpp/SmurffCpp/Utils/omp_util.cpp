@@ -11,8 +11,6 @@ namespace threads
     // _OPENMP will be enabled if -fopenmp flag is passed to the compiler (use cmake release build)
     #if defined(_OPENMP)
 
-    #include <omp.h>
-
     static int  m_verbose = 0;
 
     int get_num_threads()
@@ -25,11 +23,6 @@ namespace threads
         return omp_get_max_threads();
     }
 
-    int get_thread_num()
-    {
-        return omp_get_thread_num(); 
-    }
-
 
     void init(int verbose, int num_threads) 
     {
@@ -51,6 +44,11 @@ namespace threads
         }
     }
 
+    void set_num_threads(int num_threads)
+    {
+        omp_set_num_threads(num_threads);
+    }
+
     #else
 
     void init(int verbose, int) 
@@ -62,9 +60,10 @@ namespace threads
 
     }
 
+    void set_num_threads(int) {}
+
     int  get_num_threads() { return 1; }
     int  get_max_threads() { return 1; }
-    int  get_thread_num() { return 0; } 
 
     #endif // _OPENMP
 }
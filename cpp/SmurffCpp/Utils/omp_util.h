@@ -1,11 +1,28 @@
 #pragma once
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 namespace threads
 {
 void init(int verbose, int num_threads);
 
+// threads of the parallel regions started by the calling thread only,
+// for background threads (init also sets the global verbosity)
+void set_num_threads(int num_threads);
+
 int get_num_threads();
 int get_max_threads();
-int get_thread_num();
+
+// inline, it is called for every thread_vector::local()
+inline int get_thread_num()
+{
+#if defined(_OPENMP)
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
 
 } // namespace threads
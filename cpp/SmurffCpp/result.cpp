@@ -14,6 +14,7 @@
 
 #include <SmurffCpp/Model.h>
 #include <SmurffCpp/result.h>
+#include <SmurffCpp/Predict/SampleEnsemble.h>
 
 #include <SmurffCpp/Utils/Error.h>
 #include <SmurffCpp/Utils/SaveState.h>
@@ -159,6 +160,18 @@ void Result::restore(const SaveState &sf)
 
 //model - holds samples (U matrices)
 void Result::update(const Model &model, bool burnin)
+{
+   updatePredictions([&model](const PVec<> &pos) { return model.predict(pos); }, burnin);
+}
+
+void Result::update(const SampleEnsemble &ensemble, int s, bool burnin)
+{
+   updatePredictions([&ensemble, s](const PVec<> &pos) { return ensemble.predict(s, pos); }, burnin);
+}
+
+//predict - returns the prediction at a position
+template<typename Predict>
+void Result::updatePredictions(const Predict &predict, bool burnin)
 {
    if (m_predictions.empty())
       return;
@@ -173,18 +186,12 @@ void Result::update(const Model &model, bool burnin)
       for(size_t k = 0; k < m_predictions.size(); ++k)
       {
          auto &t = m_predictions.operator[](k);
-         t.pred_1sample = model.predict(t.coords); //dot product of i'th columns in each U matrix
+         t.pred_1sample = predict(t.coords); //dot product of i'th columns in each U matrix
          se_1sample += std::pow(t.val - t.pred_1sample, 2);
       }
 
       burnin_iter++;
       rmse_1sample = std::sqrt(se_1sample / NNZ);
-
-      if (classify)
-      {
-         auc_1sample = calc_auc(m_predictions, threshold,
-               [](const ResultItem &a, const ResultItem &b) { return a.pred_1sample < b.pred_1sample;});
-      }
    }
    else
    {
@@ -195,7 +202,7 @@ void Result::update(const Model &model, bool burnin)
       for(size_t k = 0; k < m_predictions.size(); ++k)
       {
          auto &t = m_predictions.operator[](k);
-         const double pred = model.predict(t.coords); //dot product of i'th columns in each U matrix
+         const double pred = predict(t.coords); //dot product of i'th columns in each U matrix
          t.update(pred);
 
          se_1sample += std::pow(t.val - pred, 2);
@@ -205,16 +212,81 @@ void Result::update(const Model &model, bool burnin)
       sample_iter++;
       rmse_1sample = std::sqrt(se_1sample / NNZ);
       rmse_avg = std::sqrt(se_avg / NNZ);
+   }
 
-      if (classify)
-      {
-         auc_1sample = calc_auc(m_predictions, threshold,
-               [](const ResultItem &a, const ResultItem &b) { return a.pred_1sample < b.pred_1sample;});
+   updateAuc(burnin);
+}
 
-         auc_avg = calc_auc(m_predictions, threshold,
-               [](const ResultItem &a, const ResultItem &b) { return a.pred_avg < b.pred_avg;});
-      }
+void Result::update(const BatchPrediction &batch, int nsamples)
+{
+   if (m_predictions.empty())
+      return;
+
+   const size_t NNZ = m_predictions.size();
+   THROWERROR_ASSERT(batch.mean.size() == (Eigen::Index)NNZ);
+
+   double se_1sample = 0.0;
+   double se_avg = 0.0;
+
+   #pragma omp parallel for schedule(static) reduction(+:se_1sample, se_avg)
+   for(size_t k = 0; k < NNZ; ++k)
+   {
+      auto &t = m_predictions.operator[](k);
+      t.nsamples = nsamples;
+      t.pred_1sample = batch.last(k);
+      t.pred_avg = batch.mean(k);
+      t.var = batch.var(k) * (nsamples - 1); // sum of squared deviations, as ResultItem::update
+
+      se_1sample += std::pow(t.val - t.pred_1sample, 2);
+      se_avg += std::pow(t.val - t.pred_avg, 2);
    }
+
+   sample_iter = nsamples; // the batch replaces everything, unlike merge
+   rmse_1sample = std::sqrt(se_1sample / NNZ);
+   rmse_avg = std::sqrt(se_avg / NNZ);
+
+   updateAuc(false);
+}
+
+void Result::merge(const BatchPrediction &batch, int nsamples)
+{
+   if (m_predictions.empty())
+      return;
+
+   const size_t NNZ = m_predictions.size();
+   THROWERROR_ASSERT(batch.mean.size() == (Eigen::Index)NNZ);
+
+   double se_1sample = 0.0;
+   double se_avg = 0.0;
+
+   #pragma omp parallel for schedule(static) reduction(+:se_1sample, se_avg)
+   for(size_t k = 0; k < NNZ; ++k)
+   {
+      auto &t = m_predictions.operator[](k);
+      t.merge(batch.mean(k), batch.var(k) * (nsamples - 1), nsamples, batch.last(k));
+
+      se_1sample += std::pow(t.val - t.pred_1sample, 2);
+      se_avg += std::pow(t.val - t.pred_avg, 2);
+   }
+
+   sample_iter += nsamples;
+   rmse_1sample = std::sqrt(se_1sample / NNZ);
+   rmse_avg = std::sqrt(se_avg / NNZ);
+
+   updateAuc(false);
+}
+
+void Result::updateAuc(bool burnin)
+{
+   if (!classify)
+      return;
+
+   auc_1sample = calc_auc(m_predictions, threshold,
+         [](const ResultItem &a, const ResultItem &b) { return a.pred_1sample < b.pred_1sample;});
+
+   if (!burnin)
+      auc_avg = calc_auc(m_predictions, threshold,
+            [](const ResultItem &a, const ResultItem &b) { return a.pred_avg < b.pred_avg;});
 }
 
 std::ostream &Result::info(std::ostream &os, std::string indent) const
@@ -14,6 +14,8 @@ class StateFile;
 
 class Model;
 class Data;
+class SampleEnsemble;
+struct BatchPrediction;
 
 template<typename Item, typename Compare>
 double calc_auc(const std::vector<Item> &predictions,
@@ -75,6 +77,17 @@ public:
 
    //-- prediction metrics
    void update(const Model &model, bool burnin);
+   // with sample s of the ensemble
+   void update(const SampleEnsemble &ensemble, int s, bool burnin);
+   // with nsamples samples at once, batch has one entry per item in m_predictions
+   void update(const BatchPrediction &batch, int nsamples);
+   // same, combined with the samples seen so far
+   void merge(const BatchPrediction &batch, int nsamples);
+
+private:
+   template<typename Predict>
+   void updatePredictions(const Predict &predict, bool burnin);
+   void updateAuc(bool burnin);
 
 public:
    double rmse_avg = NAN;
@@ -10,6 +10,8 @@
 #include <SmurffCpp/Configs/Config.h>
 #include <SmurffCpp/Sessions/TrainSession.h>
 #include <SmurffCpp/Predict/PredictSession.h>
+#include <SmurffCpp/Predict/ModelPack.h>
+#include <SmurffCpp/Predict/ServingModel.h>
 #include <SmurffCpp/Utils/MatrixUtils.h>
 #include <SmurffCpp/Utils/StateFile.h>
 #include <SmurffCpp/result.h>
@@ -111,6 +113,677 @@ TEST_CASE("TrainSession/TensorBPMF")
 
 //=================================================================
 
+TEST_CASE("TrainSession/PostMuLambda")
+{
+  Config config = genConfig(trainDenseMatrix, testSparseMatrix, {PriorTypes::normal, PriorTypes::normal});
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+  std::string model_file = config.getSaveName();
+
+  TrainSession(config).run();
+
+  StateFile sf(model_file);
+  const auto steps = sf.openSampleSteps();
+  REQUIRE(steps.size() == (size_t)config.getNSamples());
+
+  // mean and covariance of the saved samples of mode 0
+  Matrix U, sum, prod;
+  for (const auto &step : steps)
+  {
+    step.readModel(0, U);
+    if (sum.size() == 0)
+    {
+      sum = Matrix::Zero(U.rows(), U.cols());
+      prod = Matrix::Zero(U.rows(), U.cols() * U.cols());
+    }
+    sum += U;
+    for (int i = 0; i < U.rows(); i++)
+    {
+      Matrix cov = U.row(i).transpose() * U.row(i);
+      prod.row(i) += Eigen::Map<const Vector>(cov.data(), cov.size());
+    }
+  }
+
+  // the posterior is saved with the final sample
+  Matrix mu, Lambda;
+  for (const auto &step : steps)
+    if (step.getIsample() == config.getNSamples())
+      step.readPostMuLambda(0, mu, Lambda);
+  REQUIRE(mu.size() > 0);
+
+  const int n = steps.size();
+  const int K = U.cols();
+  for (int i = 0; i < U.rows(); i++)
+  {
+    Vector s = sum.row(i);
+    Matrix p = Eigen::Map<const Matrix>(prod.row(i).data(), K, K);
+    Matrix cov = (p - s.transpose() * s / n) / (n - 1);
+    Matrix prec = Eigen::Map<const Matrix>(Lambda.row(i).data(), K, K);
+
+    REQUIRE(matrix_utils::equals_vector(mu.row(i), s / n, 1e-8));
+    REQUIRE((prec * cov - Matrix::Identity(K, K)).norm() < 1e-8);
+  }
+}
+
+TEST_CASE("TrainSession/PipelinedEval")
+{
+  Config config = genConfig(trainSparseMatrix, testSparseMatrix, {PriorTypes::normal, PriorTypes::normal});
+
+  TrainSession sequential(config);
+  sequential.run();
+
+  config.setPipelinedEval(true);
+  config.setEvalThreads(2);
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+  TrainSession pipelined(config);
+  pipelined.run();
+
+  // evaluation does not touch the sampler, only the scores lag
+  checkValue(pipelined.getRmseAvg(), sequential.getRmseAvg(), rmse_epsilon);
+  checkValue(pipelined.getRmseAvg(), pipelined.getResult().rmse_avg, rmse_epsilon);
+  REQUIRE(pipelined.getResult().sample_iter == config.getNSamples());
+}
+
+TEST_CASE("StateFile/CompressedSamples")
+{
+  Config config;
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+
+  Matrix U = Matrix::Random(10, 3) * 100;
+  {
+    StateFile sf(config.getSaveName(), true);
+    HDF5Group::StorageOptions options;
+    options.chunk_rows = 4;
+    options.deflate = 6;
+    options.sample_bits = 16;
+    sf.setStorageOptions(options);
+    sf.createSampleStep(1, false).putModel({U});
+  }
+
+  StateFile sf(config.getSaveName());
+  const auto steps = sf.openSampleSteps();
+  REQUIRE(steps.size() == 1);
+
+  // half precision keeps 11 significant bits
+  Matrix full;
+  steps[0].readModel(0, full);
+  REQUIRE(full.rows() == U.rows());
+  REQUIRE(full.cols() == U.cols());
+  REQUIRE((full - U).cwiseAbs().maxCoeff() <= U.cwiseAbs().maxCoeff() / 2048);
+
+  // a row range spanning two chunks
+  Matrix rows;
+  steps[0].readModel(0, rows, 3, 4);
+  REQUIRE(rows == full.middleRows(3, 4));
+}
+
+TEST_CASE("StateFile/SampleIndex")
+{
+  Config config;
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+
+  Matrix U = Matrix::Random(4, 2);
+  {
+    StateFile sf(config.getSaveName(), true);
+    for (int isample = 1; isample <= 12; ++isample)
+      sf.createSampleStep(isample, false).putModel({U * isample});
+    sf.createStep(12, true, false).putModel({U});
+
+    // out of order and twice, one written but not yet indexed
+    for (int isample : {2, 1, 3, 4, 5, 6, 7, 8, 9, 11, 10, 12, 10})
+      sf.indexSampleStep(isample);
+    sf.createSampleStep(13, false).putModel({U});
+  }
+
+  const std::vector<int> expected{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  {
+    StateFile sf(config.getSaveName());
+    REQUIRE(sf.getSampleNumbers() == expected);
+
+    // in sample order, not in the order of the group names
+    const auto steps = sf.openSampleSteps();
+    REQUIRE(steps.size() == expected.size());
+    for (std::size_t i = 0; i < steps.size(); ++i)
+      REQUIRE(steps[i].getIsample() == expected[i]);
+
+    // random access
+    REQUIRE(sf.hasSampleStep(10));
+    REQUIRE(!sf.hasSampleStep(20));
+    Matrix row;
+    sf.openSampleStep(10).readModel(0, row, 2, 1);
+    REQUIRE(row == U.row(2) * 10);
+    REQUIRE_THROWS(sf.openSampleStep(20));
+  }
+
+  // files written without an index
+  h5::File(config.getSaveName(), h5::File::ReadWrite).unlink("steps");
+  std::vector<int> all(expected);
+  all.push_back(13);
+  REQUIRE(StateFile(config.getSaveName()).getSampleNumbers() == all);
+
+  // and indexed once a new step is added
+  StateFile sf(config.getSaveName());
+  sf.createSampleStep(14, false).putModel({U});
+  sf.indexSampleStep(14);
+  all.push_back(14);
+  REQUIRE(sf.getSampleNumbers() == all);
+}
+
+TEST_CASE("PredictSession/SelectedRows")
+{
+  Config config;
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+
+  const int K = 3;
+  Matrix U0 = Matrix::Random(100, K);
+  Matrix U1 = Matrix::Random(50, K);
+  {
+    StateFile sf(config.getSaveName(), true);
+    for (int isample = 1; isample <= 3; ++isample)
+    {
+      SaveState step = sf.createSampleStep(isample, false);
+      step.putModel({U0 * isample, U1});
+      for (int m = 0; m < 2; ++m)
+      {
+        step.putLinkMatrix(m, Matrix());
+        step.putMu(m, Matrix::Zero(1, K));
+      }
+    }
+  }
+
+  // one mode, rows in any order, repeated
+  const auto steps = StateFile(config.getSaveName()).openSampleSteps();
+  RestoreSelection select;
+  select.modes = {0};
+  select.rows = {{7, 3, 4, 3}};
+  Model model;
+  model.restore(steps.at(1), select);
+  REQUIRE(model.getDims() == PVec<>({4, -1}));
+  REQUIRE(model.U(1).rows() == 0);
+  for (int i = 0; i < 4; ++i)
+    REQUIRE(model.U(0).row(i) == U0.row(select.rows[0][i]) * 2);
+
+  // entries in few rows of mode 0 and many of mode 1
+  SparseMatrix Y(100, 50);
+  Y.insert(5, 2) = 1.0;
+  Y.insert(5, 9) = 2.0;
+  Y.insert(60, 2) = 3.0;
+  for (int j = 10; j < 40; ++j)
+    Y.insert(61, j) = 4.0;
+  Y.makeCompressed();
+
+  PredictSession s(config.getSaveName());
+  REQUIRE(s.getNumLatent() == K);
+  REQUIRE(s.getModelDims() == PVec<>({100, 50}));
+
+  auto few = s.predict(DataConfig(Y));
+  REQUIRE(s.ensemble().getDims() == PVec<>({100, 50})); // the full rows, loaded after
+  auto blocks = s.predict(DataConfig(Y), 2);
+  auto all = s.predict(DataConfig(Y));
+
+  for (std::size_t k = 0; k < all->m_predictions.size(); ++k)
+  {
+    const auto &item = all->m_predictions[k];
+    const double dot = U0.row(item.coords[0]).dot(U1.row(item.coords[1]));
+    REQUIRE(item.pred_avg == Approx(2 * dot));
+    REQUIRE(few->m_predictions[k].pred_avg == Approx(item.pred_avg));
+    REQUIRE(few->m_predictions[k].var == Approx(item.var));
+    REQUIRE(blocks->m_predictions[k].pred_avg == Approx(item.pred_avg));
+    REQUIRE(blocks->m_predictions[k].var == Approx(item.var));
+  }
+}
+
+TEST_CASE("PredictSession/CompressedSave")
+{
+  Config config = genConfig(trainDenseMatrix, testSparseMatrix, {PriorTypes::normal, PriorTypes::normal});
+  config.setSaveChunkRows(1);
+  config.setSaveDeflate(1);
+  config.setSaveSampleBits(32);
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+  std::string model_file = config.getSaveName();
+
+  TrainSession trainSession(config);
+  trainSession.run();
+
+  PredictSession s(model_file);
+  auto result = s.predict(config.getTest());
+  checkValue(trainSession.getRmseAvg(), result->rmse_avg, 1e-5);
+
+  // single elements only read the rows they need
+  for (const auto &item : result->m_predictions)
+  {
+    auto single = s.predict(item.coords);
+    REQUIRE(single.pred_avg == Approx(item.pred_avg));
+  }
+}
+
+TEST_CASE("TrainSession/CheckpointFullPrecision")
+{
+  Config config = genConfig(trainDenseMatrix, testSparseMatrix, {PriorTypes::normal, PriorTypes::normal});
+  config.setSaveSampleBits(16);
+  config.setCheckpointFreq(1);
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+
+  TrainSession trainSession(config);
+  trainSession.run();
+
+  // samples are lossy, the checkpoint to resume from is not
+  Config restoreConfig = config;
+  restoreConfig.setRestoreName(config.getSaveName());
+  restoreConfig.setSaveName(std::string());
+  TrainSession restored(restoreConfig);
+  restored.init();
+
+  for (std::uint64_t m = 0; m < trainSession.model().nmodes(); ++m)
+    REQUIRE(restored.model().U(m) == trainSession.model().U(m));
+}
+
+TEST_CASE("PredictSession/SampleEnsemble")
+{
+  Config config = genConfig(trainSparseTensor3d, testSparseTensor3d, {PriorTypes::normal, PriorTypes::normal, PriorTypes::normal});
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+  std::string model_file = config.getSaveName();
+  TrainSession(config).run();
+
+  PredictSession s(model_file);
+  const auto steps = StateFile(model_file).openSampleSteps();
+
+  const SampleEnsemble &all = s.ensemble();
+  REQUIRE(all.nsamples() == config.getNSamples());
+  REQUIRE(all.nmodes() == 3);
+  REQUIRE(s.getNumLatent() == config.getNumLatent());
+
+  Matrix U;
+  steps.back().readModel(2, U);
+  REQUIRE(all.U(all.nsamples() - 1, 2) == U);
+
+  // one element, from memory
+  auto result = s.predict(config.getTest());
+  const auto &item = result->m_predictions.front();
+  REQUIRE(s.predict(item.coords).pred_avg == Approx(item.pred_avg));
+
+  // the rows of mode 1 as new rows, against all entries of modes 0 and 2
+  const auto dims = all.getDims();
+  const int K = all.nlatent();
+  const int S = all.nsamples();
+  FoldedRows rows{1, Matrix(dims[1], S * K)};
+  for (int k = 0; k < S; ++k)
+    rows.latents.middleCols(k * K, K) = all.U(k, 1);
+
+  Matrix mean, var;
+  all.predict_rows(rows, mean, var);
+  REQUIRE(mean.rows() == dims[1]);
+  REQUIRE(mean.cols() == dims[0] * dims[2]);
+
+  std::vector<PVec<>> coords;
+  for (int i = 0; i < dims[0]; ++i)
+    for (int j = 0; j < dims[1]; ++j)
+      for (int l = 0; l < dims[2]; ++l)
+        coords.push_back(PVec<>({i, j, l}));
+  auto batch = all.predict_batch(rows, coords);
+
+  for (int e = 0; e < (int)coords.size(); ++e)
+  {
+    const auto &pos = coords[e];
+    ResultItem expected(pos);
+    all.predict(expected);
+    REQUIRE(batch.mean(e) == Approx(expected.pred_avg));
+    REQUIRE(batch.var(e) == Approx(expected.var / (S - 1)));
+    REQUIRE(mean(pos[1], pos[0] * dims[2] + pos[2]) == Approx(expected.pred_avg));
+    REQUIRE(var(pos[1], pos[0] * dims[2] + pos[2]) == Approx(expected.var / (S - 1)));
+  }
+
+  // a selection of the samples
+  s.loadEnsemble({0, 2});
+  REQUIRE(s.ensemble().nsamples() == 2);
+  REQUIRE(s.ensemble().getIsample(1) == steps.at(2).getIsample());
+  steps.at(2).readModel(0, U);
+  REQUIRE(s.ensemble().U(1, 0) == U);
+}
+
+TEST_CASE("PredictSession/BatchPrediction")
+{
+  Config config = genConfig(trainDenseMatrix, testSparseMatrix, {PriorTypes::normal, PriorTypes::normal});
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+  std::string model_file = config.getSaveName();
+  TrainSession(config).run();
+
+  PredictSession s(model_file);
+  const SampleEnsemble &samples = s.ensemble();
+  const int S = samples.nsamples();
+
+  // dense block, all entries, compared against one sample at a time
+  std::vector<int> rows{2, 0}, cols{1, 3, 0};
+  std::vector<PVec<>> coords;
+  for (int i : rows)
+    for (int j : cols)
+      coords.push_back(PVec<>({i, j}));
+
+  auto block = s.predict_batch(rows, cols, {0.0, 0.5, 1.0});
+  auto batch = s.predict_batch(coords, {0.0, 0.5, 1.0});
+
+  for (int e = 0; e < (int)coords.size(); ++e)
+  {
+    std::vector<double> p;
+    ResultItem item(coords[e]);
+    for (int k = 0; k < S; ++k)
+    {
+      p.push_back(samples.predict(k, coords[e]));
+      item.update(p.back());
+    }
+    std::sort(p.begin(), p.end());
+
+    for (const auto &b : {block, batch})
+    {
+      REQUIRE(b.mean(e) == Approx(item.pred_avg));
+      REQUIRE(b.var(e) == Approx(item.var / (S - 1)));
+      REQUIRE(b.last(e) == Approx(item.pred_1sample));
+      REQUIRE(b.quantiles[0](e) == Approx(p.front()));
+      REQUIRE(b.quantiles[1](e) == Approx((p[(S - 1) / 2] + p[S / 2]) / 2));
+      REQUIRE(b.quantiles[2](e) == Approx(p.back()));
+    }
+  }
+}
+
+TEST_CASE("PredictSession/PrefetchedBlocks")
+{
+  Config config = genConfig(trainDenseMatrix, testSparseMatrix, {PriorTypes::normal, PriorTypes::normal});
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+  std::string model_file = config.getSaveName();
+  TrainSession(config).run();
+
+  PredictSession s(model_file);
+  const int S = s.getNumSteps();
+  auto expected = s.predict(config.getTest());
+  REQUIRE(expected->sample_iter == S);
+
+  // a second batch replaces the first
+  auto twice = s.predict(config.getTest());
+  std::vector<PVec<>> coords;
+  for (const auto &item : twice->m_predictions)
+    coords.push_back(item.coords);
+  twice->update(s.predict_batch(coords), S);
+  REQUIRE(twice->sample_iter == S);
+
+  // uneven blocks, one block, one sample per block
+  for (int block_samples : {3, S, 1})
+  {
+    auto result = s.predict(config.getTest(), block_samples);
+    REQUIRE(result->sample_iter == S);
+    REQUIRE(result->rmse_avg == Approx(expected->rmse_avg));
+    REQUIRE(result->rmse_1sample == Approx(expected->rmse_1sample));
+
+    for (std::size_t k = 0; k < expected->m_predictions.size(); ++k)
+    {
+      const auto &a = result->m_predictions[k];
+      const auto &b = expected->m_predictions[k];
+      REQUIRE(a.nsamples == S);
+      REQUIRE(a.pred_avg == Approx(b.pred_avg));
+      REQUIRE(a.var == Approx(b.var));
+      REQUIRE(a.pred_1sample == Approx(b.pred_1sample));
+    }
+  }
+}
+
+TEST_CASE("PredictSession/ModelPack")
+{
+  Config config = genConfig(trainDenseMatrix, testSparseMatrix, {PriorTypes::normal, PriorTypes::normal});
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+  std::string model_file = config.getSaveName();
+  TrainSession(config).run();
+
+  PredictSession s(model_file);
+  std::string pack_file = model_file + ".pack";
+  s.saveModelPack(pack_file);
+  REQUIRE(ModelPack::isModelPack(pack_file));
+  REQUIRE(!ModelPack::isModelPack(model_file));
+
+  PredictSession p(pack_file);
+  REQUIRE(p.getNumSteps() == s.getNumSteps());
+  REQUIRE(p.getNumLatent() == s.getNumLatent());
+  REQUIRE(p.getModelDims() == s.getModelDims());
+
+  const SampleEnsemble &a = s.ensemble();
+  const SampleEnsemble &b = p.ensemble();
+  for (int k = 0; k < a.nsamples(); ++k)
+  {
+    REQUIRE(b.getIsample(k) == a.getIsample(k));
+    for (int m = 0; m < a.nmodes(); ++m)
+    {
+      REQUIRE(b.U(k, m) == a.U(k, m));
+      REQUIRE(b.getLinkMatrix(k, m) == a.getLinkMatrix(k, m));
+      REQUIRE(b.getMu(k, m) == a.getMu(k, m));
+    }
+  }
+
+  auto expected = s.predict(config.getTest());
+  auto result = p.predict(config.getTest());
+  auto blocks = p.predict(config.getTest(), 2);
+  for (std::size_t k = 0; k < expected->m_predictions.size(); ++k)
+  {
+    REQUIRE(result->m_predictions[k].pred_avg == Approx(expected->m_predictions[k].pred_avg));
+    REQUIRE(result->m_predictions[k].var == Approx(expected->m_predictions[k].var));
+    REQUIRE(blocks->m_predictions[k].pred_avg == Approx(expected->m_predictions[k].pred_avg));
+  }
+
+  // the steps themselves are not in the pack
+  REQUIRE_THROWS(p.loadEnsemble({0}));
+}
+
+TEST_CASE("PredictSession/TopN")
+{
+  Config config = genConfig(trainDenseMatrix, testSparseMatrix, {PriorTypes::normal, PriorTypes::normal});
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+  std::string model_file = config.getSaveName();
+  TrainSession(config).run();
+
+  PredictSession s(model_file);
+  const auto dims = s.ensemble().getDims();
+  const int N = 2;
+
+  // compared against scoring the full rows
+  for (int mode = 0; mode < 2; ++mode)
+  {
+    std::vector<int> rows(dims[mode]), cols(dims[1 - mode]);
+    std::iota(rows.begin(), rows.end(), 0);
+    std::iota(cols.begin(), cols.end(), 0);
+
+    auto top = s.topN(mode, rows, N);
+    auto all = mode == 0 ? s.predict_batch(rows, cols) : s.predict_batch(cols, rows);
+    REQUIRE(top.size() == rows.size());
+
+    for (int i : rows)
+    {
+      auto index = [&](int j) { return mode == 0 ? i * cols.size() + j : j * rows.size() + i; };
+
+      std::vector<double> means;
+      for (int j : cols)
+        means.push_back(all.mean(index(j)));
+      std::sort(means.rbegin(), means.rend());
+
+      REQUIRE(top[i].size() == N);
+      for (int k = 0; k < N; ++k)
+      {
+        const auto &r = top[i][k];
+        REQUIRE(r.mean == Approx(means[k]));
+        REQUIRE(r.mean == Approx(all.mean(index(r.item))));
+        REQUIRE(r.var == Approx(all.var(index(r.item))));
+      }
+    }
+  }
+
+  REQUIRE_THROWS(s.topN(0, std::vector<int>{0}, 0));
+}
+
+TEST_CASE("PredictSession/FoldIn")
+{
+  Config config = genConfig(trainDenseMatrix, testSparseMatrix, {PriorTypes::normal, PriorTypes::normal});
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+  std::string model_file = config.getSaveName();
+  TrainSession(config).run();
+
+  PredictSession s(model_file);
+  const SampleEnsemble &samples = s.ensemble();
+  const int S = samples.nsamples();
+  const int K = samples.nlatent();
+  const int M = samples.getDims()[1];
+
+  // a new row observed in every column, with a copy of row 0 and an empty row
+  SparseMatrix Y(2, M);
+  for (int j = 0; j < M; ++j)
+    Y.insert(0, j) = trainDenseMatrix(0, j);
+  Y.makeCompressed();
+
+  // almost noiseless: per sample, a least squares fit to the observations
+  const double alpha = 1e8;
+  auto folded = s.foldIn(0, Y, alpha);
+  REQUIRE(folded.latents.rows() == 2);
+  REQUIRE(folded.latents.cols() == S * K);
+
+  for (int k = 0; k < S; ++k)
+  {
+    const auto V = samples.U(k, 1);
+    const Vector u = folded.latents.block(0, k * K, 1, K);
+    const Vector y = trainDenseMatrix.row(0);
+    const Vector grad = (y - u * V.transpose()) * V;
+    REQUIRE(grad.norm() <= 1e-2 * (y * V).norm() + 1e-6);
+  }
+
+  std::vector<int> cols(M);
+  std::iota(cols.begin(), cols.end(), 0);
+  auto batch = s.predict_batch(folded, cols);
+  auto top = s.topN(folded, 1);
+  REQUIRE(top.size() == 2);
+  for (int r = 0; r < 2; ++r)
+    REQUIRE(top[r][0].mean == Approx(batch.mean.segment(r * M, M).maxCoeff()));
+}
+
+TEST_CASE("PredictSession/ServingModel")
+{
+  Config config = genConfig(trainDenseMatrix, testSparseMatrix, {PriorTypes::normal, PriorTypes::normal});
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+  std::string model_file = config.getSaveName();
+  TrainSession(config).run();
+
+  const int K = config.getNumLatent();
+  PredictSession s(model_file);
+  s.saveServingModel(model_file + ".serving", 0, K);
+  s.saveServingModel(model_file + ".serving8", 8, K);
+  ServingModel full(model_file + ".serving");
+  ServingModel quantized(model_file + ".serving8");
+  REQUIRE(full.varRank() == K);
+
+  // posterior mean and covariance saved with the last sample
+  auto steps = StateFile(model_file).openSampleSteps();
+  auto last = std::max_element(steps.begin(), steps.end(),
+    [](const SaveState &a, const SaveState &b) { return a.getIsample() < b.getIsample(); });
+  std::vector<Matrix> mu(2), cov(2);
+  for (int m = 0; m < 2; ++m)
+    last->readPostMuLambda(m, mu[m], cov[m]);
+
+  const auto dims = full.getDims();
+  for (int i = 0; i < dims[0]; ++i)
+    for (int j = 0; j < dims[1]; ++j)
+    {
+      Matrix Su = Eigen::Map<const Matrix>(cov[0].row(i).data(), K, K).inverse();
+      Matrix Sv = Eigen::Map<const Matrix>(cov[1].row(j).data(), K, K).inverse();
+      const auto &u = mu[0].row(i);
+      const auto &v = mu[1].row(j);
+      const double expected_var = (v * Su * v.transpose())(0, 0) + (u * Sv * u.transpose())(0, 0) + (Su * Sv).trace();
+
+      double var;
+      REQUIRE(full.predict({i, j}, var) == Approx(u.dot(v)));
+      REQUIRE(var == Approx(expected_var));
+    }
+
+  // 8 bit: within half a step of the per-row scale
+  for (int m = 0; m < 2; ++m)
+    for (int i = 0; i < dims[m]; ++i)
+    {
+      const auto &exact = full.mean(m).row(i);
+      const double step = exact.cwiseAbs().maxCoeff() / 127;
+      REQUIRE((quantized.mean(m).row(i) - exact).cwiseAbs().maxCoeff() <= step / 2 + 1e-12);
+    }
+}
+
+TEST_CASE("PredictSession/StreamingFeatures")
+{
+  const SideInfoConfig rowSideInfoDenseMatrixConfig = makeSideInfoConfig(rowSideDenseMatrix);
+
+  Config config = genConfig(trainDenseMatrix, testSparseMatrix, {PriorTypes::macau, PriorTypes::normal});
+  config.addSideInfo(0, rowSideInfoDenseMatrixConfig);
+  prepareResultDir(config, Catch::getResultCapture().getCurrentTestName());
+  std::string model_file = config.getSaveName();
+  TrainSession(config).run();
+
+  PredictSession s(model_file);
+  const SampleEnsemble &samples = s.ensemble();
+  const int S = samples.nsamples();
+  const auto &f = rowSideInfoDenseMatrixConfig.getDenseMatrixData();
+  const int R = f.rows();
+  const int M = samples.getDims()[1];
+
+  // one sample at a time, the full feature matrix at once
+  std::vector<ResultItem> expected;
+  for (int i = 0; i < R; ++i)
+    for (int j = 0; j < M; ++j)
+      expected.push_back(ResultItem(PVec<>({i, j})));
+  for (int k = 0; k < S; ++k)
+  {
+    Matrix P = samples.predict(k, 0, f);
+    for (auto &item : expected)
+      item.update(P(item.coords[0], item.coords[1]));
+  }
+
+  // chunks of 2 rows
+  Matrix mean(R, M), var(R, M);
+  samples.predict_rows(0, f, [&](int first_row, const Matrix &m, const Matrix &v) {
+    REQUIRE(m.rows() <= 2);
+    mean.middleRows(first_row, m.rows()) = m;
+    var.middleRows(first_row, v.rows()) = v;
+  }, 2);
+
+  std::vector<PVec<>> coords;
+  for (const auto &item : expected)
+    coords.push_back(item.coords);
+  std::reverse(coords.begin(), coords.end());
+  auto batch = s.predict_batch(0, f, coords, 2);
+
+  for (int e = 0; e < (int)expected.size(); ++e)
+  {
+    const auto &item = expected[e];
+    const int i = item.coords[0], j = item.coords[1];
+    REQUIRE(mean(i, j) == Approx(item.pred_avg));
+    REQUIRE(var(i, j) == Approx(item.var / (S - 1)));
+
+    const int b = expected.size() - 1 - e;
+    REQUIRE(batch.mean(b) == Approx(item.pred_avg));
+    REQUIRE(batch.var(b) == Approx(item.var / (S - 1)));
+    REQUIRE(batch.last(b) == Approx(item.pred_1sample));
+  }
+
+  // top-N does not depend on the chunk size
+  auto top = s.topN(0, f, 2, 1);
+  auto top_all = s.topN(0, f, 2);
+  REQUIRE(top.size() == R);
+  for (int i = 0; i < R; ++i)
+  {
+    REQUIRE(top[i][0].mean == Approx(mean.row(i).maxCoeff()));
+    for (int k = 0; k < 2; ++k)
+      REQUIRE(top[i][k].item == top_all[i][k].item);
+  }
+
+  // to HDF5
+  const std::string path = model_file + ".pred";
+  s.predict_stream(0, f, path, 3);
+  h5::File file(path, h5::File::ReadOnly);
+  HDF5Group out(file.getGroup("/"));
+  Matrix saved_avg, saved_var;
+  out.read(PREDICTIONS_SECTION, PRED_AVG_DATASET, saved_avg);
+  out.read(PREDICTIONS_SECTION, PRED_VAR_DATASET, saved_var);
+  REQUIRE(matrix_utils::equals(saved_avg, mean, 1e-9));
+  REQUIRE(matrix_utils::equals(saved_var, var, 1e-9));
+}
+
 TEST_CASE("PredictSession/Features/1", TAG_MATRIX_TESTS) {
   const SideInfoConfig rowSideInfoDenseMatrixConfig = makeSideInfoConfig(rowSideDenseMatrix);
 
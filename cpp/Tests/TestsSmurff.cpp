@@ -177,6 +177,29 @@ TEST_CASE("train_sparse_matrix_test_sparse_matrix_normal_normal_dense_matrix_den
       .runAndCheck(523);
 }
 
+TEST_CASE("train_sparse_matrix_test_sparse_matrix_normal_normal_propagated_posterior",
+          TAG_MATRIX_TESTS) {
+
+  Config config = genConfig(trainSparseMatrix, testSparseMatrix, {PriorTypes::normal, PriorTypes::normal});
+  const int K = config.getNumLatent();
+  const int N = trainSparseMatrix.rows();
+
+  // a very sharp posterior pins all row latents to its mean
+  // (the predictions are not pinned: the other mode can compensate)
+  Matrix mu = Matrix::Constant(K, N, 0.5);
+  Matrix Lambda(K * K, N);
+  Matrix sharp = Matrix::Identity(K, K) * 1e8;
+  for (int n = 0; n < N; ++n)
+    Lambda.col(n) = Eigen::Map<const Vector>(sharp.data(), K * K).transpose();
+  config.addPropagatedPosterior(0, mu, Lambda);
+
+  TrainSession trainSession(config);
+  trainSession.run();
+
+  const Matrix &U = trainSession.model().U(0);
+  REQUIRE((U.array() - 0.5).abs().maxCoeff() < 1e-2);
+}
+
 //=================================================================
 
 TEST_CASE("train_dense_matrix_test_sparse_matrix_spikeandslab_spikeandslab_none_none",
@@ -481,5 +504,21 @@ TEST_CASE("train_sparse_3d_tensor_test_sparse_3d_tensor_macauone_normal_row_dens
       .addSideInfo(0, rowSideDenseMatrix3d)
       .runAndCheck(3280);
 }
+
+TEST_CASE("mixed_precision_needs_sparse_side_info")
+{
+  const SparseMatrix binarySideMatrix = matrix_utils::make_sparse({ 3, 1 }, { {0, 1, 2}, {0, 0, 0} }, {1., 1., 1.});
+
+  auto configWith = [](const SideInfoConfig &si) {
+    Config config = genConfig(trainDenseMatrix, testSparseMatrix, {PriorTypes::macau, PriorTypes::normal});
+    config.addSideInfo(0, si).setMixedPrecision(true);
+    return config;
+  };
+
+  REQUIRE(configWith(makeSideInfoConfig(rowSideSparseMatrix, false)).validate());
+  REQUIRE_THROWS(configWith(makeSideInfoConfig(rowSideDenseMatrix)).validate());
+  REQUIRE_THROWS(configWith(makeSideInfoConfig(binarySideMatrix)).validate());
+}
+
 } // namespace test
 } // namespace smurff
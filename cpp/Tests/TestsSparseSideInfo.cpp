@@ -1,6 +1,8 @@
 #include "catch.hpp"
 
 #include <SmurffCpp/SideInfo/SparseSideInfo.h>
+#include <SmurffCpp/SideInfo/BinarySparseSideInfo.h>
+#include <SmurffCpp/SideInfo/MixedSparseSideInfo.h>
 #include <SmurffCpp/SideInfo/linop.h>
 #include <SmurffCpp/Utils/Distribution.h>
 #include <SmurffCpp/Utils/MatrixUtils.h>
@@ -188,4 +190,174 @@ TEST_CASE( "SparseSideInfo/compute_uhat", "[compute_uhat] for SparseSideInfo" )
     }
 }
 
+TEST_CASE( "SparseSideInfo/kernels_blocked", "multithreaded kernels match Eigen over several row blocks" )
+{
+    const int nrows = 150, ncols = 70;
+    SparseMatrix F(nrows, ncols);
+    for (int i = 0; i < nrows; i++)
+        for (int k = 0; k < 3; k++)
+            F.coeffRef(i, (i * 7 + k * 13) % ncols) = 0.1 * (k + 1) - 0.01 * (i % 5);
+    F.makeCompressed();
+
+    SparseSideInfo si = SparseSideInfo(DataConfig(F));
+
+    Matrix AA;
+    si.At_mul_A(AA);
+    REQUIRE( AA.isApprox(Matrix(F.transpose() * F)) );
+
+    Matrix beta = Matrix::Ones(ncols, 4);
+    for (int f = 0; f < ncols; f++) beta.row(f) *= (f % 11) - 5.0;
+
+    Matrix uhat;
+    si.compute_uhat(uhat, beta);
+    REQUIRE( uhat.isApprox(Matrix(F * beta)) );
+
+    Matrix X = Matrix::Ones(nrows, 4);
+    for (int i = 0; i < nrows; i++) X.row(i) *= (i % 7) - 3.0;
+    REQUIRE( si.A_mul_B(X).isApprox(Matrix(F.transpose() * X)) );
+}
+
+TEST_CASE( "SparseSideInfo/feature_groups", "features in a group never share an item" )
+{
+    SparseSideInfo si = SparseSideInfo(DataConfig(sideInfo));
+    auto groups = si.feature_groups();
+
+    std::vector<int> seen(si.cols(), 0);
+    for (const auto &group : groups)
+    {
+        std::vector<int> items(si.rows(), 0);
+        for (int f : group)
+        {
+            seen[f]++;
+            for (SparseMatrix::InnerIterator it(si.Ft, f); it; ++it)
+                REQUIRE( items[it.col()]++ == 0 );
+        }
+    }
+
+    for (int f = 0; f < si.cols(); f++)
+        REQUIRE( seen[f] == 1 );
+
+    // the 6x4 sideInfo has items with two features, so some parallelism is possible
+    REQUIRE( (int)groups.size() < si.cols() );
+}
+
+static SparseMatrix binarySideInfo = matrix_utils::make_sparse(
+    {6, 4},
+    {{0, 3, 3, 2, 5, 4, 1, 2, 4}, {1, 0, 2, 1, 3, 0, 1, 3, 2}},
+    {1., 1., 1., 1., 1., 1., 1., 1., 1.});
+
+TEST_CASE( "BinarySparseSideInfo/isBinary", "[isBinary] for DataConfig" )
+{
+    REQUIRE( DataConfig(binarySideInfo).isBinary() );
+    REQUIRE( !DataConfig(sideInfo).isBinary() );
+    REQUIRE( !DataConfig(Matrix(Matrix::Ones(2, 2))).isBinary() );
+}
+
+TEST_CASE( "BinarySparseSideInfo/kernels", "BinarySparseSideInfo matches SparseSideInfo" )
+{
+    SparseSideInfo si = SparseSideInfo(DataConfig(binarySideInfo));
+    BinarySparseSideInfo bi = BinarySparseSideInfo(DataConfig(binarySideInfo));
+
+    REQUIRE( bi.rows() == si.rows() );
+    REQUIRE( bi.cols() == si.cols() );
+
+    Matrix AA(4, 4), bAA(4, 4);
+    si.At_mul_A(AA);
+    bi.At_mul_A(bAA);
+    REQUIRE( bAA.isApprox(AA) );
+
+    REQUIRE( bi.col_square_sum().isApprox(si.col_square_sum()) );
+
+    Matrix X(6, 3);
+    X << 0.6, 0., -0.82,
+         0., 1.19, 0.06,
+         -0.76, 1.48, 1.95,
+         2.54, 0., 2.44,
+         0.3, -1.2, 0.,
+         1.1, 0.45, -0.3;
+
+    REQUIRE( bi.A_mul_B(X).isApprox(si.A_mul_B(X)) );
+
+    Matrix beta(4, 3);
+    beta << 1.4, 0., 0.76,
+            -2.32, 0.12, -1.3,
+            0.45, 0.19, -1.87,
+            2.12, -1.43, -0.98;
+
+    Matrix uhat, buhat;
+    si.compute_uhat(uhat, beta);
+    bi.compute_uhat(buhat, beta);
+    REQUIRE( buhat.isApprox(uhat) );
+
+    for (int f = 0; f < bi.cols(); f++)
+    {
+        Vector Y(3), bY(3);
+        si.At_mul_Bt(Y, f, X);
+        bi.At_mul_Bt(bY, f, X);
+        REQUIRE( bY.isApprox(Y) );
+
+        Vector b(3);
+        b << 1.4, -0.46, 0.13;
+        Matrix Z = X, bZ = X;
+        si.add_Acol_mul_bt(Z, f, b);
+        bi.add_Acol_mul_bt(bZ, f, b);
+        REQUIRE( bZ.isApprox(Z) );
+    }
+}
+
+TEST_CASE( "MixedSparseSideInfo/kernels", "MixedSparseSideInfo matches SparseSideInfo" )
+{
+    // values are stored in float
+    const double prec = 1e-6;
+
+    SparseSideInfo si = SparseSideInfo(DataConfig(sideInfo));
+    MixedSparseSideInfo mi = MixedSparseSideInfo(DataConfig(sideInfo));
+
+    REQUIRE( mi.rows() == si.rows() );
+    REQUIRE( mi.cols() == si.cols() );
+
+    Matrix AA(4, 4), mAA(4, 4);
+    si.At_mul_A(AA);
+    mi.At_mul_A(mAA);
+    REQUIRE( mAA.isApprox(AA, prec) );
+
+    REQUIRE( mi.col_square_sum().isApprox(si.col_square_sum(), prec) );
+
+    Matrix X(6, 3);
+    X << 0.6, 0., -0.82,
+         0., 1.19, 0.06,
+         -0.76, 1.48, 1.95,
+         2.54, 0., 2.44,
+         0.3, -1.2, 0.,
+         1.1, 0.45, -0.3;
+
+    REQUIRE( mi.A_mul_B(X).isApprox(si.A_mul_B(X), prec) );
+
+    Matrix beta(4, 3);
+    beta << 1.4, 0., 0.76,
+            -2.32, 0.12, -1.3,
+            0.45, 0.19, -1.87,
+            2.12, -1.43, -0.98;
+
+    Matrix uhat, muhat;
+    si.compute_uhat(uhat, beta);
+    mi.compute_uhat(muhat, beta);
+    REQUIRE( muhat.isApprox(uhat, prec) );
+
+    for (int f = 0; f < mi.cols(); f++)
+    {
+        Vector Y(3), mY(3);
+        si.At_mul_Bt(Y, f, X);
+        mi.At_mul_Bt(mY, f, X);
+        REQUIRE( mY.isApprox(Y, prec) );
+
+        Vector b(3);
+        b << 1.4, -0.46, 0.13;
+        Matrix Z = X, mZ = X;
+        si.add_Acol_mul_bt(Z, f, b);
+        mi.add_Acol_mul_bt(mZ, f, b);
+        REQUIRE( mZ.isApprox(Z, prec) );
+    }
+}
+
 } // end namespace smurff
@@ -1,6 +1,7 @@
 #define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
 #include "catch.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <iostream>
@@ -17,6 +18,9 @@
 #include <SmurffCpp/Utils/Distribution.h>
 #include <SmurffCpp/Utils/counters.h>
 #include <SmurffCpp/Utils/MatrixUtils.h>
+#include <SmurffCpp/Utils/RowScheduler.h>
+#include <SmurffCpp/Utils/BackgroundWriter.h>
+#include <SmurffCpp/Utils/ThreadVector.hpp>
 
 #include <SmurffCpp/Configs/DataConfig.h>
 
@@ -116,6 +120,130 @@ TEST_CASE( "utils/eval_rmse", "Test if prediction variance is correctly calculat
   REQUIRE(p.rmse_avg == Approx(std::sqrt(std::pow(4.5 - ((1.0 * 1.0 + 0.0 * 0.0) + (2.0 * 1.0 + 0.0 * 0.0) + (2.0 * 3.0 + 0.0 * 0.0)) / 3, 2) / 1)));
 }
 
+TEST_CASE( "model/active", "Test if all-zero latent dimensions are skipped")
+{
+  Model model;
+  model.init(3, PVec<>({2, 2}), ModelInitTypes::zero, false);
+
+  // after init everything is active
+  REQUIRE(model.active().size() == 3);
+
+  model.U(0) << 1.0, 0.0, 2.0,
+                3.0, 0.0, 0.0;
+  model.U(1) << 1.0, 5.0, 0.0,
+                2.0, 6.0, 0.0;
+  model.updateActive(0);
+  model.updateActive(1);
+
+  REQUIRE(model.active() == std::vector<int>({0}));
+  // non-zero in every mode but the given one
+  REQUIRE(model.active(0) == std::vector<int>({0, 1}));
+  REQUIRE(model.active(1) == std::vector<int>({0, 2}));
+
+  REQUIRE(model.predict(PVec<>({0, 1})) == Approx(2.0));
+  REQUIRE(model.predict(PVec<>({1, 0})) == Approx(3.0));
+}
+
+TEST_CASE( "utils/chol_rank1_update", "Test rank-1 update of an upper triangular Cholesky factor")
+{
+  Matrix A(3, 3);
+  A << 4.0, 1.0, 0.5,
+       1.0, 3.0, 0.2,
+       0.5, 0.2, 2.0;
+  Matrix R = A.llt().matrixU();
+
+  Matrix X(2, 3);
+  X << 0.3, -1.2, 0.7,
+       1.5,  0.4, -0.1;
+  Matrix expected = A + X.transpose() * X;
+
+  for (int i = 0; i < X.rows(); i++)
+  {
+     Vector x = X.row(i);
+     matrix_utils::chol_rank1_update(R, x);
+  }
+
+  REQUIRE(R.isUpperTriangular());
+  REQUIRE(matrix_utils::equals(R.transpose() * R, expected, 1e-12));
+}
+
+TEST_CASE( "utils/thread_vector", "Test per-thread storage and its reduction")
+{
+  thread_vector<Vector> tv(Vector::Zero(3));
+
+  REQUIRE(tv.size() == threads::get_max_threads());
+
+  // coefficients of every thread start on a cache line of their own
+  std::vector<std::uintptr_t> addr;
+  for (const auto &v : tv)
+    addr.push_back(reinterpret_cast<std::uintptr_t>(v.data()));
+  REQUIRE(addr.front() % 64 == 0);
+  for (std::size_t i = 1; i < addr.size(); i++)
+    REQUIRE(addr[i] - addr[i - 1] == 64);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(tv.local().data()) % 64 == 0);
+
+  // other values sit in aligned slots
+  thread_vector<double> td(0.);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(&td.local()) % 64 == 0);
+
+  #pragma omp parallel for
+  for (int i = 0; i < 100; i++)
+     tv.local() += Vector::Constant(3, i);
+
+  Vector sum = Vector::Ones(3);
+  tv.combine_and_reset(sum);
+  REQUIRE(sum(0) == Approx(4950.0));
+  REQUIRE(sum(2) == Approx(4950.0));
+
+  // reset to the initial value
+  REQUIRE(tv.combine().isZero());
+}
+
+TEST_CASE( "utils/background_writer", "Test if jobs run in order and errors reach the caller")
+{
+  std::vector<int> done;
+  {
+    BackgroundWriter writer(2);
+    for (int i = 0; i < 10; i++)
+      writer.push([&done, i]() { done.push_back(i); });
+    writer.flush();
+    REQUIRE(done.size() == 10);
+    REQUIRE(std::is_sorted(done.begin(), done.end()));
+
+    writer.push([]() { throw std::runtime_error("disk full"); });
+    REQUIRE_THROWS_AS(writer.flush(), std::runtime_error);
+
+    // the writer stays usable after an error
+    writer.push([&done]() { done.push_back(10); });
+  }
+  REQUIRE(done.size() == 11);
+}
+
+TEST_CASE( "utils/row_scheduler", "Test if every row is scheduled exactly once")
+{
+  std::vector<int> nnz(500, 3);
+  nnz[7] = 5000;
+  nnz[123] = 20000;
+  nnz[499] = 0;
+
+  RowScheduler scheduler;
+  scheduler.init(nnz);
+
+  for (int sweep = 0; sweep < 3; sweep++)
+  {
+     std::vector<int> count(nnz.size(), 0);
+     scheduler.run([&count](int n) {
+        #pragma omp atomic
+        count[n]++;
+     });
+
+     REQUIRE(std::all_of(count.begin(), count.end(), [](int c) { return c == 1; }));
+     REQUIRE(scheduler.chunk_size() >= 1);
+     REQUIRE(scheduler.c0() >= 0.0);
+     REQUIRE(scheduler.c1() >= 0.0);
+  }
+}
+
 TEST_CASE("utils/auc","AUC ROC") {
   struct TestItem {
       double pred, val;
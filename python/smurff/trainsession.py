@@ -52,6 +52,24 @@ class TrainSession(PythonSession):
     checkpoint_freq: int
         Save the state of the trainSession every N seconds.
 
+    save_chunk_rows: int
+        Rows per HDF5 chunk of saved matrices. 0 means about 1MB per chunk.
+
+    save_deflate: int
+        Gzip level (1-9) of saved matrices. 0 means uncompressed.
+
+    save_sample_bits: {0, 32, 16}
+        Store the saved samples as 32 or 16 bit floats (lossy).
+        0 means full precision.
+
+    pipelined_eval: bool
+        Evaluate the test set of a sample while the next sample is drawn.
+        Status lines then report the test scores of the previous sample.
+
+    eval_threads: int
+        Number of OpenMP threads of the pipelined evaluation. These run
+        next to the num_threads threads of the sampler, not in their place.
+
     """
     #
     # construction functions
@@ -68,6 +86,11 @@ class TrainSession(PythonSession):
         save_name        = None,
         save_freq        = None,
         checkpoint_freq  = None,
+        save_chunk_rows  = None,
+        save_deflate     = None,
+        save_sample_bits = None,
+        pipelined_eval   = None,
+        eval_threads     = None,
         ):
 
         super().__init__()
@@ -83,6 +106,11 @@ class TrainSession(PythonSession):
         if save_name is not None:       self.setSaveName(save_name)
         if save_freq is not None:       self.setSaveFreq(save_freq)
         if checkpoint_freq is not None: self.setCheckpointFreq(checkpoint_freq)
+        if save_chunk_rows is not None: self.setSaveChunkRows(save_chunk_rows)
+        if save_deflate is not None:    self.setSaveDeflate(save_deflate)
+        if save_sample_bits is not None: self.setSaveSampleBits(save_sample_bits)
+        if pipelined_eval is not None:  self.setPipelinedEval(pipelined_eval)
+        if eval_threads is not None:    self.setEvalThreads(eval_threads)
 
 
     def addTrainAndTest(self, Y, Ytest = None, noise = FixedNoise(), is_scarce = True):
@@ -112,7 +140,7 @@ class TrainSession(PythonSession):
         
         super().setTrain(Y, noise, is_scarce)
        
-    def addSideInfo(self, mode, Y, noise = SampledNoise(), direct = True):
+    def addSideInfo(self, mode, Y, noise = SampledNoise(), direct = True, mixed_precision = False):
         """Adds fully known side info, for use in with the macau or macauone prior
 
         mode : int
@@ -132,8 +160,13 @@ class TrainSession(PythonSession):
 
             The direct method is only feasible for a small (< 100K) number of features.
 
+        mixed_precision : boolean
+            When True and `Y` is sparse (not binary), stores `Y` in single precision.
+            With `direct` False the CG solver then runs in float, and its solution
+            is refined in double precision.
+
         """
-        super().addSideInfo(mode, Y, noise, direct)
+        super().addSideInfo(mode, Y, noise, direct, mixed_precision)
 
     def addPropagatedPosterior(self, mode, mu, Lambda):
         """Adds mu and Lambda from propagated posterior
@@ -85,12 +85,17 @@ PYBIND11_MODULE(wrapper, m)
         .def("setSaveName", &smurff::PythonSession::setSaveName)
         .def("setSaveFreq", &smurff::PythonSession::setSaveFreq)
         .def("setCheckpointFreq", &smurff::PythonSession::setCheckpointFreq)
+        .def("setSaveChunkRows", &smurff::PythonSession::setSaveChunkRows)
+        .def("setSaveDeflate", &smurff::PythonSession::setSaveDeflate)
+        .def("setSaveSampleBits", &smurff::PythonSession::setSaveSampleBits)
         .def("setRandomSeed", &smurff::PythonSession::setRandomSeed)
         .def("setVerbose", &smurff::PythonSession::setVerbose)
         .def("setBurnin", &smurff::PythonSession::setBurnin)
         .def("setNSamples", &smurff::PythonSession::setNSamples)
         .def("setNumLatent", &smurff::PythonSession::setNumLatent)
         .def("setNumThreads", &smurff::PythonSession::setNumThreads)
+        .def("setPipelinedEval", &smurff::PythonSession::setPipelinedEval)
+        .def("setEvalThreads", &smurff::PythonSession::setEvalThreads)
         .def("setThreshold", &smurff::PythonSession::setThreshold)
 
         .def("setTest", &smurff::PythonSession::setTest<smurff::SparseMatrix>)